@@ -1,53 +1,85 @@
 #include "Algorithms.hpp"
+#include "Parallel.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
 
 using namespace std;
 using ariel::Algorithms;
-using ariel::Graph;
+using ariel::BitMatrix;
+using ariel::GraphView;
+using ariel::Edge;
+using ariel::NeighborIterator;
+using ariel::NeighborRange;
+using ariel::parallelFor;
+using ariel::PathMatrix;
+using ariel::PathStrategy;
+using ariel::QueryStats;
+using ariel::Representation;
+using ariel::WeightRange;
+using ariel::WeightTraits;
 
-/// @brief Performs Depth-First Search (DFS) to recursively find cycles in the graph.
-/// @param v The current vertex being visited.
+/// @brief Performs Depth-First Search (DFS) to find cycles reachable from a vertex.
+/// Uses an explicit stack so that long paths cannot overflow the call stack.
+/// @param v The vertex the search starts from.
 /// @param visited A vector to keep track of visited vertices.
-/// @param recStack A stack to track vertices in the current recursion stack.
-/// @param graph The adjacency matrix representing the graph.
+/// @param recStack A stack to track vertices on the current search path.
+/// @param graph The graph being searched.
 /// @param parent A vector to record the parent vertex of each vertex, used for cycle detection.
 /// @return True if a cycle is detected in the graph, false otherwise.
-bool Algorithms::dfs(size_t v, vector<bool> &visited, vector<bool> &recStack, const vector<vector<int>> &graph, vector<size_t> &parent)
+template <typename W>
+bool Algorithms::dfs(size_t v, pmr::vector<bool> &visited, pmr::vector<bool> &recStack, const GraphView<W> &graph, pmr::vector<size_t> &parent)
 {
+    struct Frame
+    {
+        size_t vertex;
+        NeighborIterator<W> next;
+        NeighborIterator<W> last;
+    };
+    pmr::vector<Frame> stack(visited.get_allocator());
+
     visited[v] = true;
     recStack[v] = true;
+    NeighborRange<W> edges = graph.neighbors(v);
+    stack.push_back({v, edges.begin(), edges.end()});
 
-    for (size_t i = 0; i < graph[v].size(); ++i)
+    while (!stack.empty())
     {
-        if (graph[v][i])
+        Frame &top = stack.back();
+        if (top.next == top.last)
         {
-            if (!visited[i])
-            {
-                parent[i] = v;
-                if (dfs(i, visited, recStack, graph, parent))
-                {
-                    return true;
-                }
-            }
-            else if (recStack[i])
-            {
-                return true;
-            }
+            recStack[top.vertex] = false;
+            stack.pop_back();
+            continue;
+        }
+        size_t i = (*top.next).to;
+        ++top.next;
+        if (!visited[i])
+        {
+            parent[i] = top.vertex;
+            visited[i] = true;
+            recStack[i] = true;
+            edges = graph.neighbors(i);
+            stack.push_back({i, edges.begin(), edges.end()});
+        }
+        else if (recStack[i])
+        {
+            return true;
         }
     }
 
-    recStack[v] = false;
     return false;
 }
 
 /// @brief Checks if the graph component starting from the specified vertex is bipartite.
 /// @param start The starting vertex for bipartite checking.
-/// @param graph The adjacency matrix of the graph.
+/// @param graph The graph being searched.
 /// @param colors A vector to store colors of vertices, where INF indicates uncolored.
-/// @param groups A vector of vectors that represent the 2 color groups.
 /// @return True if the component is bipartite, false otherwise.
-bool Algorithms::isComponentBipartite(size_t start, const vector<vector<int>> &graph, vector<size_t> &colors, vector<vector<size_t>> &groups)
+template <typename W>
+bool Algorithms::isComponentBipartite(size_t start, const GraphView<W> &graph, pmr::vector<size_t> &colors)
 {
-    queue<size_t> q;
+    queue<size_t, pmr::deque<size_t>> q(colors.get_allocator());
     q.push(start);
     colors[start] = 0;
 
@@ -56,68 +88,231 @@ bool Algorithms::isComponentBipartite(size_t start, const vector<vector<int>> &g
         size_t current = q.front();
         q.pop();
 
-        for (size_t neighbor = 0; neighbor < graph[current].size(); ++neighbor)
+        for (Edge<W> edge : graph.neighbors(current))
+        {
+            size_t neighbor = edge.to;
+            if (colors[neighbor] == INF)
+            {
+                colors[neighbor] = 1 - colors[current];
+                q.push(neighbor);
+            }
+            else if (colors[neighbor] == colors[current])
+            {
+                // If the vertex has been visited and is the same color as the previous vertex, return false (not bipartite)
+                return false;
+            }
+        }
+    }
+
+    // All checks passed, return true (bipartite)
+    return true;
+}
+
+// Index of the lowest set bit of a non-zero word
+static size_t lowestBit(uint64_t word)
+{
+    return size_t(__builtin_ctzll(word));
+}
+
+/// @brief Checks if every vertex is reachable from vertex 0, a whole frontier at a time.
+/// Each BFS level ORs the rows of the frontier vertices and masks out the visited set, 64 vertices per word.
+/// @param adjacency The bit-packed adjacency matrix of the graph.
+/// @param scratch Where the vertex sets are allocated.
+/// @return True if every vertex was reached, false otherwise.
+bool Algorithms::reachesAll(const BitMatrix &adjacency, pmr::memory_resource *scratch)
+{
+    size_t words = adjacency.wordsPerRow();
+    pmr::vector<uint64_t> visited(words, 0, scratch);
+    pmr::vector<uint64_t> frontier(words, 0, scratch);
+    pmr::vector<uint64_t> next(words, 0, scratch);
+    visited[0] = frontier[0] = 1;
+    size_t reached = 1;
+
+    while (reached > 0)
+    {
+        fill(next.begin(), next.end(), 0);
+        for (size_t w = 0; w < words; ++w)
         {
-            if (graph[current][neighbor] != 0)
+            for (uint64_t bits = frontier[w]; bits != 0; bits &= bits - 1)
             {
-                if (colors[neighbor] == INF)
+                const uint64_t *row = adjacency.row(w * BitMatrix::WORD_BITS + lowestBit(bits));
+                for (size_t k = 0; k < words; ++k)
                 {
-                    colors[neighbor] = 1 - colors[current];
-                    q.push(neighbor);
+                    next[k] |= row[k];
                 }
-                else if (colors[neighbor] == colors[current])
+            }
+        }
+        reached = 0;
+        for (size_t k = 0; k < words; ++k)
+        {
+            frontier[k] = next[k] & ~visited[k];
+            visited[k] |= frontier[k];
+            reached += size_t(__builtin_popcountll(frontier[k]));
+        }
+    }
+
+    size_t count = 0;
+    for (uint64_t word : visited)
+    {
+        count += size_t(__builtin_popcountll(word));
+    }
+    return count == adjacency.size();
+}
+
+/// @brief Detects a cycle with an iterative DFS over the bit-packed adjacency matrix.
+/// A back edge exists from a vertex iff its row intersects the set of vertices on the current path,
+/// and unvisited children are found with (row & ~visited) one word at a time.
+/// @param adjacency The bit-packed adjacency matrix of the graph.
+/// @param scratch Where the vertex sets and the stack are allocated.
+/// @return True if a cycle is detected in the graph, false otherwise.
+bool Algorithms::containsCycle(const BitMatrix &adjacency, pmr::memory_resource *scratch)
+{
+    size_t n = adjacency.size();
+    size_t words = adjacency.wordsPerRow();
+    pmr::vector<uint64_t> visited(words, 0, scratch);
+    pmr::vector<uint64_t> onPath(words, 0, scratch);
+    pmr::vector<pair<size_t, size_t>> stack(scratch); // (vertex, next word of its row to scan)
+
+    for (size_t start = 0; start < n; ++start)
+    {
+        if ((visited[start / BitMatrix::WORD_BITS] >> (start % BitMatrix::WORD_BITS)) & 1U)
+        {
+            continue;
+        }
+        stack.emplace_back(start, 0);
+        visited[start / BitMatrix::WORD_BITS] |= uint64_t(1) << (start % BitMatrix::WORD_BITS);
+        onPath[start / BitMatrix::WORD_BITS] |= uint64_t(1) << (start % BitMatrix::WORD_BITS);
+        for (size_t k = 0; k < words; ++k)
+        {
+            if (adjacency.row(start)[k] & onPath[k])
+            {
+                return true;
+            }
+        }
+
+        while (!stack.empty())
+        {
+            size_t v = stack.back().first;
+            size_t &w = stack.back().second;
+            const uint64_t *row = adjacency.row(v);
+            while (w < words && (row[w] & ~visited[w]) == 0)
+            {
+                ++w;
+            }
+            if (w == words)
+            {
+                onPath[v / BitMatrix::WORD_BITS] &= ~(uint64_t(1) << (v % BitMatrix::WORD_BITS));
+                stack.pop_back();
+                continue;
+            }
+            size_t child = w * BitMatrix::WORD_BITS + lowestBit(row[w] & ~visited[w]);
+            visited[child / BitMatrix::WORD_BITS] |= uint64_t(1) << (child % BitMatrix::WORD_BITS);
+            onPath[child / BitMatrix::WORD_BITS] |= uint64_t(1) << (child % BitMatrix::WORD_BITS);
+            const uint64_t *childRow = adjacency.row(child);
+            for (size_t k = 0; k < words; ++k)
+            {
+                if (childRow[k] & onPath[k])
                 {
-                    // If the vertex has been visited and is the same color as the previous vertex, return false (not bipartite)
-                    return false;
+                    return true;
                 }
             }
+            stack.emplace_back(child, 0);
         }
     }
+    return false;
+}
 
-    // Add the vertices to groups
-    vector<size_t> group1;
-    vector<size_t> group2;
+/// @brief 2-colors the graph with a BFS over the bit-packed adjacency matrix.
+/// A vertex conflicts iff its row intersects the set of its own color; its uncolored
+/// neighbors are (row & ~(color0 | color1)), all taken the opposite color at once.
+/// @param adjacency The bit-packed adjacency matrix of the graph.
+/// @param colors Receives the color (0 or 1) of every vertex when the graph is bipartite; its allocator
+/// is used for the rest of the scratch state.
+/// @param rounds Receives, for every vertex, the number of the search (one per uncolored start vertex) that colored it.
+/// @return True if the graph is bipartite, false otherwise.
+bool Algorithms::isBipartite(const BitMatrix &adjacency, pmr::vector<size_t> &colors, pmr::vector<size_t> &rounds)
+{
+    size_t n = adjacency.size();
+    size_t words = adjacency.wordsPerRow();
+    pmr::memory_resource *scratch = colors.get_allocator().resource();
+    pmr::vector<uint64_t> colorSets[2] = {pmr::vector<uint64_t>(words, 0, scratch), pmr::vector<uint64_t>(words, 0, scratch)};
+    queue<size_t, pmr::deque<size_t>> q(scratch);
+    colors.assign(n, INF);
+    rounds.assign(n, INF);
+    size_t round = 0;
 
-    for (size_t i = 0; i < colors.size(); i++)
+    for (size_t start = 0; start < n; ++start)
     {
-        if (colors[i] == 0)
+        if (colors[start] != INF)
         {
-            group1.push_back(i);
+            continue;
         }
-        else
+        colors[start] = 0;
+        rounds[start] = round++;
+        colorSets[0][start / BitMatrix::WORD_BITS] |= uint64_t(1) << (start % BitMatrix::WORD_BITS);
+        q.push(start);
+
+        while (!q.empty())
         {
-            group2.push_back(i);
+            size_t current = q.front();
+            q.pop();
+            size_t color = colors[current];
+            pmr::vector<uint64_t> &same = colorSets[color];
+            pmr::vector<uint64_t> &opposite = colorSets[1 - color];
+            const uint64_t *row = adjacency.row(current);
+            for (size_t k = 0; k < words; ++k)
+            {
+                if (row[k] & same[k])
+                {
+                    return false;
+                }
+                uint64_t uncolored = row[k] & ~(same[k] | opposite[k]);
+                opposite[k] |= uncolored;
+                for (; uncolored != 0; uncolored &= uncolored - 1)
+                {
+                    size_t neighbor = k * BitMatrix::WORD_BITS + lowestBit(uncolored);
+                    colors[neighbor] = 1 - color;
+                    rounds[neighbor] = rounds[current];
+                    q.push(neighbor);
+                }
+            }
         }
     }
-    groups.push_back(group1);
-    groups.push_back(group2);
-
-    // All checks passed, return true (bipartite)
     return true;
 }
 
 // Helper method for Bellman-Ford to relax an edge if possible
-bool relaxEdges(const vector<vector<int>> &graph, vector<int> &distance, vector<size_t> &parent, bool &negativeCycleDetected)
+template <typename W, typename Distance>
+static bool relaxEdges(const GraphView<W> &graph, pmr::vector<Distance> &distance, pmr::vector<size_t> &parent, bool &negativeCycleDetected)
 {
-    size_t n = graph.size();
+    const Distance unreachable = WeightTraits<W>::infinity();
+    const Distance unbounded = WeightTraits<W>::negativeInfinity();
+    size_t n = graph.getVertices();
     bool relaxed = false; // Flag to keep track if edges have been relaxed or not
 
     // Relaxes all edges once
     for (size_t u = 0; u < n; ++u)
     {
-        for (size_t v = 0; v < n; ++v)
+        if (distance[u] == unreachable)
         {
-            if (graph[u][v] != 0 && distance[u] != INF && distance[u] + graph[u][v] < distance[v])
+            continue;
+        }
+        for (Edge<W> edge : graph.neighbors(u))
+        {
+            size_t v = edge.to;
+            // Negative infinity stays negative infinity instead of wrapping around
+            Distance candidate = distance[u] == unbounded ? unbounded : WeightTraits<W>::add(distance[u], Distance(edge.weight));
+            if (candidate < distance[v])
             {
                 // If a negative cycle has been detected, set distance to negative infinity
                 if (negativeCycleDetected)
                 {
-                    distance[v] = NEG_INF;
+                    distance[v] = unbounded;
                 }
                 // Otherwise, update distance and parent vectors
                 else
                 {
-                    distance[v] = distance[u] + graph[u][v];
+                    distance[v] = candidate;
                     parent[v] = u;
                 }
                 relaxed = true;
@@ -129,32 +324,71 @@ bool relaxEdges(const vector<vector<int>> &graph, vector<int> &distance, vector<
     return relaxed;
 }
 
+// Finds a cycle of parent pointers by following them from each vertex in turn until a vertex seen on the same walk
+// comes up again; walk[v] is set to the first vertex of the walk that passed v. Returns a vertex on the cycle, or INF.
+static size_t findParentCycle(const pmr::vector<size_t> &parent, pmr::vector<size_t> &walk)
+{
+    size_t n = parent.size();
+    walk.assign(n, INF);
+    for (size_t first = 0; first < n; ++first)
+    {
+        size_t v = first;
+        while (v != INF && walk[v] == INF)
+        {
+            walk[v] = first;
+            v = parent[v];
+        }
+        if (v != INF && walk[v] == first)
+        {
+            return v;
+        }
+    }
+    return INF;
+}
+
 /// @brief Uses the Bellman-Ford algorithm to detect negative weight cycles from a given starting vertex.
-/// @param start The starting vertex for the Bellman-Ford algorithm.
-/// @param graph The adjacency matrix of the graph.
+/// @param start The starting vertex for the Bellman-Ford algorithm, or EVERY_VERTEX to start from a virtual vertex with a
+/// zero-weight edge to every vertex, which finds a negative cycle anywhere in the graph.
+/// @param graph The graph being searched.
 /// @param distance A vector to store the shortest path distances from the start vertex.
-/// @param parent A vector to store the predecessor of each vertex in the path.
+/// @param parent A vector to store the predecessor of each vertex in the path. Once a negative cycle is found, the
+/// predecessors contain a cycle, and every cycle of predecessors is a negative cycle.
+/// @param markUnbounded Whether to set the distance of every vertex reachable from a negative cycle to negative infinity.
+/// If not, the search stops as soon as the predecessors contain a cycle.
 /// @return True if a negative weight cycle is found, false otherwise.
-bool Algorithms::bellmanFord(size_t start, const vector<vector<int>> &graph, vector<int> &distance, vector<size_t> &parent)
+template <typename W>
+bool Algorithms::bellmanFord(size_t start, const GraphView<W> &graph, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent, bool markUnbounded)
 {
-    size_t n = graph.size();
-    distance.assign(n, INF);
+    size_t n = graph.getVertices();
     parent.assign(n, INF);
-    distance[start] = 0;
+    if (start == EVERY_VERTEX)
+    {
+        // The edges from the virtual vertex are relaxed already, and no path from it has more than n edges
+        distance.assign(n, 0);
+    }
+    else
+    {
+        distance.assign(n, WeightTraits<W>::infinity());
+        distance[start] = 0;
+    }
 
     // Iterate to relax edges
     bool negativeCycleDetected = false;
+    pmr::vector<size_t> walk(parent.get_allocator());
     for (size_t i = 0; i < n - 1; ++i)
     {
         if (!relaxEdges(graph, distance, parent, negativeCycleDetected))
             break; // No need to continue if no relaxation occurred
+        // A cycle of predecessors is a negative cycle; finding one costs O(n), less than a round
+        if (!markUnbounded && findParentCycle(parent, walk) != INF)
+            return true;
     }
 
     // Check for negative cycles
     negativeCycleDetected = relaxEdges(graph, distance, parent, negativeCycleDetected);
 
     // If negative cycle found, update affected vertices
-    if (negativeCycleDetected)
+    if (negativeCycleDetected && markUnbounded)
     {
         for (size_t i = 0; i < n - 1; ++i)
         {
@@ -165,15 +399,392 @@ bool Algorithms::bellmanFord(size_t start, const vector<vector<int>> &graph, vec
     return negativeCycleDetected;
 }
 
+/// @brief A queue-based Bellman-Ford (SPFA) for graphs with negative weights: only the edges of vertices whose distance
+/// changed are relaxed again, instead of every edge every round. Vertices whose new distance is smaller than that of
+/// the vertex at the front of the queue jump ahead of it (small label first), and vertices above the average distance
+/// in the queue are moved to the back instead of being scanned (large label last), so that small distances spread first.
+/// Each distance comes from a walk, and the number of its edges is kept; a walk of n edges repeats a vertex, which only
+/// happens when the walk goes around a negative cycle.
+/// @param start The starting vertex, or EVERY_VERTEX to start from a virtual vertex with a zero-weight edge to every vertex.
+/// @param graph The graph being searched.
+/// @param distance A vector to store the shortest path distances from the start vertex.
+/// @param parent A vector to store the predecessor of each vertex in the path.
+/// @param markUnbounded Whether to go on after a negative cycle is found and set the distance of every vertex reachable
+/// from a negative cycle to negative infinity, or stop at the first one.
+/// @return True if a negative weight cycle is found, false otherwise.
+template <typename W>
+bool Algorithms::labelCorrecting(size_t start, const GraphView<W> &graph, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent, bool markUnbounded)
+{
+    using Distance = typename WeightTraits<W>::Accumulator;
+    const Distance unbounded = WeightTraits<W>::negativeInfinity();
+    size_t n = graph.getVertices();
+    pmr::memory_resource *scratch = distance.get_allocator().resource();
+    pmr::vector<size_t> edges(n, 0, scratch); // edges of the walk each distance comes from
+    pmr::vector<char> queued(n, false, scratch);
+    deque<size_t, pmr::polymorphic_allocator<size_t>> queue(scratch);
+    pmr::vector<size_t> reachable(scratch);
+    double queuedSum = 0;   // sum of the distances of the queued vertices, for the average
+    size_t queuedCount = 0; // queued vertices; the queue also holds the stale entries of dequeued ones
+    parent.assign(n, INF);
+    if (start == EVERY_VERTEX)
+    {
+        distance.assign(n, 0);
+        for (size_t v = 0; v < n; ++v)
+        {
+            queue.push_back(v);
+            queued[v] = true;
+        }
+        queuedCount = n;
+    }
+    else
+    {
+        distance.assign(n, WeightTraits<W>::infinity());
+        distance[start] = 0;
+        queue.push_back(start);
+        queued[start] = true;
+        queuedCount = 1;
+    }
+
+    // Takes a vertex out of the queue's average; its entry is skipped when it reaches the front
+    auto dequeue = [&](size_t v)
+    {
+        if (queued[v])
+        {
+            queuedSum -= double(distance[v]);
+            --queuedCount;
+            queued[v] = false;
+        }
+    };
+    // Sets the distance of v and everything reachable from it to negative infinity
+    auto markFrom = [&](size_t v)
+    {
+        dequeue(v);
+        distance[v] = unbounded;
+        reachable.assign(1, v);
+        while (!reachable.empty())
+        {
+            size_t w = reachable.back();
+            reachable.pop_back();
+            for (Edge<W> edge : graph.neighbors(w))
+            {
+                if (distance[edge.to] != unbounded)
+                {
+                    dequeue(edge.to);
+                    distance[edge.to] = unbounded;
+                    reachable.push_back(edge.to);
+                }
+            }
+        }
+    };
+
+    bool negativeCycleDetected = false;
+    while (!queue.empty())
+    {
+        double average = queuedCount == 0 ? 0 : queuedSum / double(queuedCount);
+        for (size_t moved = 0; moved + 1 < queue.size() && double(distance[queue.front()]) > average; ++moved)
+        {
+            queue.push_back(queue.front());
+            queue.pop_front();
+        }
+        size_t u = queue.front();
+        queue.pop_front();
+        if (!queued[u])
+        {
+            continue; // marked unbounded after it was queued
+        }
+        dequeue(u);
+
+        for (Edge<W> edge : graph.neighbors(u))
+        {
+            size_t v = edge.to;
+            Distance candidate = WeightTraits<W>::add(distance[u], Distance(edge.weight));
+            if (candidate >= distance[v])
+            {
+                continue;
+            }
+            if (edges[u] + 1 >= n)
+            {
+                // A walk of n edges repeats a vertex: the walk to v goes around a negative cycle
+                negativeCycleDetected = true;
+                if (!markUnbounded)
+                {
+                    return true;
+                }
+                markFrom(v);
+                if (distance[u] == unbounded)
+                {
+                    break; // u is on the cycle, and all its edges lead to marked vertices
+                }
+                continue;
+            }
+            if (queued[v])
+            {
+                queuedSum += double(candidate) - double(distance[v]);
+            }
+            else
+            {
+                queuedSum += double(candidate);
+                ++queuedCount;
+                queued[v] = true;
+                if (!queue.empty() && candidate < distance[queue.front()])
+                {
+                    queue.push_front(v);
+                }
+                else
+                {
+                    queue.push_back(v);
+                }
+            }
+            distance[v] = candidate;
+            parent[v] = u;
+            edges[v] = edges[u] + 1;
+        }
+    }
+
+    return negativeCycleDetected;
+}
+
+/// @brief Uses Dijkstra's algorithm with a 4-ary heap to find the shortest paths from a starting vertex.
+/// @param start The starting vertex.
+/// @param target The search stops once this vertex is settled; PathMatrix<W>::NO_VERTEX to settle every vertex.
+/// @param graph The graph being searched; its edge weights, adjusted by potential, must not be negative.
+/// @param potential If not null, each edge (u, v) weighs weight + potential[u] - potential[v] instead.
+/// @param distance A vector to store the (adjusted) shortest path distances from the start vertex.
+/// @param parent A vector to store the predecessor of each vertex in the path, PathMatrix<W>::NO_VERTEX if there is none.
+/// @param heap Scratch space for the queue of reached vertices.
+/// @return The number of vertices settled.
+template <typename W>
+size_t Algorithms::dijkstra(size_t start, size_t target, const GraphView<W> &graph, const typename WeightTraits<W>::Accumulator *potential, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent, DaryHeap<typename WeightTraits<W>::Accumulator> &heap)
+{
+    using Distance = typename WeightTraits<W>::Accumulator;
+    size_t n = graph.getVertices();
+    distance.assign(n, WeightTraits<W>::infinity());
+    parent.assign(n, PathMatrix<W>::NO_VERTEX);
+    heap.reset(n);
+    distance[start] = 0;
+    heap.push(start, 0);
+    size_t settled = 0;
+
+    while (!heap.empty())
+    {
+        auto [reached, u] = heap.pop();
+        ++settled;
+        if (u == target)
+        {
+            break;
+        }
+        for (Edge<W> edge : graph.neighbors(u))
+        {
+            Distance weight = Distance(edge.weight);
+            if (potential != nullptr)
+            {
+                weight = WeightTraits<W>::add(weight, WeightTraits<W>::subtract(potential[u], potential[edge.to]));
+            }
+            Distance candidate = WeightTraits<W>::add(reached, weight);
+            if (candidate < distance[edge.to])
+            {
+                distance[edge.to] = candidate;
+                parent[edge.to] = u;
+                heap.push(edge.to, candidate);
+            }
+        }
+    }
+    return settled;
+}
+
+/// @brief Finds a shortest path between two different vertices with Dijkstra's algorithm run from both ends at once:
+/// forward from start over graph and backward from target over reversed, always advancing the side whose next vertex
+/// is closer. Each edge scanned that links the two searches offers a path; the search stops once the two closest
+/// unsettled distances add up to at least the best one, since any path through an unsettled vertex is that long.
+/// Each side settles only about the ball up to half the distance, instead of the whole ball around start.
+/// @param start The starting vertex.
+/// @param target The end vertex, other than start.
+/// @param graph The graph being searched; its edge weights must not be negative.
+/// @param reversed The transpose of graph.
+/// @param path Receives the vertices of a shortest path, from start to target, or nothing if there is none.
+/// @param scratch Where the distances, parents and heaps are allocated.
+/// @return The number of vertices settled by both sides.
+template <typename W>
+size_t Algorithms::bidirectionalDijkstra(size_t start, size_t target, const GraphView<W> &graph, const GraphView<W> &reversed, vector<size_t> &path, pmr::memory_resource *scratch)
+{
+    using Distance = typename WeightTraits<W>::Accumulator;
+    const Distance infinity = WeightTraits<W>::infinity();
+    size_t n = graph.getVertices();
+    const GraphView<W> *sides[2] = {&graph, &reversed}; // side 0 searches forward from start, side 1 back from target
+    pmr::vector<Distance> distance[2] = {pmr::vector<Distance>(n, infinity, scratch), pmr::vector<Distance>(n, infinity, scratch)};
+    pmr::vector<size_t> parent[2] = {pmr::vector<size_t>(n, PathMatrix<W>::NO_VERTEX, scratch), pmr::vector<size_t>(n, PathMatrix<W>::NO_VERTEX, scratch)};
+    DaryHeap<Distance> heap[2] = {DaryHeap<Distance>(scratch), DaryHeap<Distance>(scratch)};
+    size_t ends[2] = {start, target};
+    for (int side = 0; side < 2; ++side)
+    {
+        heap[side].reset(n);
+        distance[side][ends[side]] = 0;
+        heap[side].push(ends[side], 0);
+    }
+    Distance best = infinity;
+    size_t meeting = PathMatrix<W>::NO_VERTEX;
+    size_t settled = 0;
+
+    // Once one side runs out, every vertex it reaches is settled and every link to the other side was offered
+    while (!heap[0].empty() && !heap[1].empty())
+    {
+        if (best != infinity && WeightTraits<W>::add(heap[0].topKey(), heap[1].topKey()) >= best)
+        {
+            break;
+        }
+        int side = heap[0].topKey() <= heap[1].topKey() ? 0 : 1;
+        auto [reached, u] = heap[side].pop();
+        ++settled;
+        for (Edge<W> edge : sides[side]->neighbors(u))
+        {
+            Distance candidate = WeightTraits<W>::add(reached, Distance(edge.weight));
+            if (candidate < distance[side][edge.to])
+            {
+                distance[side][edge.to] = candidate;
+                parent[side][edge.to] = u;
+                heap[side].push(edge.to, candidate);
+            }
+            Distance remaining = distance[1 - side][edge.to];
+            if (remaining != infinity && WeightTraits<W>::add(candidate, remaining) < best)
+            {
+                best = WeightTraits<W>::add(candidate, remaining);
+                meeting = edge.to;
+            }
+        }
+    }
+
+    path.clear();
+    if (meeting == PathMatrix<W>::NO_VERTEX)
+    {
+        return settled;
+    }
+    for (size_t at = meeting; at != start; at = parent[0][at])
+    {
+        path.push_back(at);
+    }
+    path.push_back(start);
+    reverse(path.begin(), path.end());
+    for (size_t at = meeting; at != target; at = parent[1][at])
+    {
+        path.push_back(parent[1][at]);
+    }
+    return settled;
+}
+
+/// @brief Finds the shortest paths from a starting vertex with a breadth-first search, for graphs whose edges all weigh
+/// the same: every vertex is settled when it is first reached, one edge further than the vertex it was reached from.
+/// @param start The starting vertex.
+/// @param target The search stops once this vertex is reached; PathMatrix<W>::NO_VERTEX to reach every vertex.
+/// @param graph The graph being searched.
+/// @param weight The weight of every edge.
+/// @param distance A vector to store the shortest path distances from the start vertex.
+/// @param parent A vector to store the predecessor of each vertex in the path, PathMatrix<W>::NO_VERTEX if there is none.
+/// @return The number of vertices settled.
+template <typename W>
+size_t Algorithms::breadthFirst(size_t start, size_t target, const GraphView<W> &graph, W weight, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent)
+{
+    using Distance = typename WeightTraits<W>::Accumulator;
+    size_t n = graph.getVertices();
+    distance.assign(n, WeightTraits<W>::infinity());
+    parent.assign(n, PathMatrix<W>::NO_VERTEX);
+    pmr::vector<size_t> queue(distance.get_allocator()); // every vertex enters once, so it never wraps
+    distance[start] = 0;
+    queue.push_back(start);
+
+    for (size_t front = 0; front < queue.size(); ++front)
+    {
+        size_t u = queue[front];
+        Distance reached = WeightTraits<W>::add(distance[u], Distance(weight));
+        for (Edge<W> edge : graph.neighbors(u))
+        {
+            if (distance[edge.to] == WeightTraits<W>::infinity())
+            {
+                distance[edge.to] = reached;
+                parent[edge.to] = u;
+                queue.push_back(edge.to);
+                if (edge.to == target)
+                {
+                    return queue.size();
+                }
+            }
+        }
+    }
+    return queue.size();
+}
+
+/// @brief Finds the shortest paths from a starting vertex with Dial's algorithm, for integral weights from 1 to largest:
+/// Dijkstra's algorithm with the heap replaced by one bucket per distance, scanned in order. Every tentative distance
+/// is within largest of the distance being settled, so largest + 1 buckets, reused in a circle, hold them all.
+/// @param start The starting vertex.
+/// @param target The search stops once this vertex is settled; PathMatrix<W>::NO_VERTEX to settle every vertex.
+/// @param graph The graph being searched.
+/// @param largest The largest edge weight.
+/// @param distance A vector to store the shortest path distances from the start vertex.
+/// @param parent A vector to store the predecessor of each vertex in the path, PathMatrix<W>::NO_VERTEX if there is none.
+/// @return The number of vertices settled.
+template <typename W>
+size_t Algorithms::dialBuckets(size_t start, size_t target, const GraphView<W> &graph, W largest, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent)
+{
+    using Distance = typename WeightTraits<W>::Accumulator;
+    size_t n = graph.getVertices();
+    distance.assign(n, WeightTraits<W>::infinity());
+    parent.assign(n, PathMatrix<W>::NO_VERTEX);
+    size_t circle = size_t(largest) + 1;
+    pmr::vector<pmr::vector<size_t>> buckets(circle, distance.get_allocator()); // a vertex may wait in several
+    distance[start] = 0;
+    buckets[0].push_back(start);
+    size_t waiting = 1;
+    size_t settled = 0;
+
+    for (Distance current = 0; waiting > 0; ++current)
+    {
+        pmr::vector<size_t> &bucket = buckets[size_t(current) % circle];
+        for (size_t u : bucket)
+        {
+            if (distance[u] != current)
+            {
+                continue; // reached by a shorter path since it was put here
+            }
+            ++settled;
+            if (u == target)
+            {
+                return settled;
+            }
+            for (Edge<W> edge : graph.neighbors(u))
+            {
+                Distance candidate = WeightTraits<W>::add(current, Distance(edge.weight));
+                if (candidate < distance[edge.to])
+                {
+                    distance[edge.to] = candidate;
+                    parent[edge.to] = u;
+                    buckets[size_t(candidate) % circle].push_back(edge.to);
+                    ++waiting;
+                }
+            }
+        }
+        waiting -= bucket.size();
+        bucket.clear();
+    }
+    return settled;
+}
+
 /// @brief Checks if the graph is connected using Breadth-First Search (BFS).
 /// @param g The Graph object to check.
+/// @param scratch Where the search state is allocated.
 /// @return True if the graph is connected, false otherwise.
-bool Algorithms::isConnected(const Graph &g)
+template <typename W>
+bool Algorithms::isConnected(const GraphView<W> &g, pmr::memory_resource *scratch)
 {
-    vector<vector<int>> graph = g.getGraph();
-    size_t vertices = size_t(g.getVertices());
-    vector<bool> visited(vertices, false);
-    queue<size_t> travers;
+    if (g.getRepresentation() == Representation::Dense)
+    {
+        bool connected = reachesAll(*g.adjacencyBits(scratch), scratch);
+        cout << (connected ? "Graph is connected!" : "Graph is not connected!") << endl;
+        return connected;
+    }
+
+    size_t vertices = g.getVertices();
+    pmr::vector<bool> visited(vertices, false, scratch);
+    queue<size_t, pmr::deque<size_t>> travers(scratch);
 
     travers.push(0); // Start traversal from vertex 0
 
@@ -185,15 +796,13 @@ bool Algorithms::isConnected(const Graph &g)
         if (!visited[curr])
         {
             visited[curr] = true;
-            size_t ind = 0;
-            for (int neighbor : graph[curr])
+            for (Edge<W> edge : g.neighbors(curr))
             {
-                // If an edge exists and we haven't visited it, add it to the queue
-                if (neighbor && !visited[ind])
+                // If we haven't visited the neighbor, add it to the queue
+                if (!visited[edge.to])
                 {
-                    travers.push(ind);
+                    travers.push(edge.to);
                 }
-                ind++;
             }
         }
     }
@@ -211,57 +820,131 @@ bool Algorithms::isConnected(const Graph &g)
     return true;
 }
 
-/// @brief Finds the shortest path between two vertices using the Bellman-Ford algorithm.
+/// @brief Finds the shortest path between two vertices.
 /// @param g The Graph object to check.
 /// @param start The starting vertex.
 /// @param end The end vertex.
+/// @param scratch Where the distances, parents and queues are allocated.
 /// @return An array of vertices that make up the shortest path.
-vector<size_t> Algorithms::shortestPath(const Graph &g, size_t start, size_t end)
+template <typename W>
+vector<size_t> Algorithms::shortestPath(const GraphView<W> &g, size_t start, size_t end, pmr::memory_resource *scratch)
 {
-    size_t vertices = g.getVertices();
-    vector<vector<int>> graph = g.getGraph();
-    vector<int> dist;
-    vector<size_t> prev;
-    bellmanFord(start, graph, dist, prev);
+    QueryStats stats;
+    return shortestPath(g, start, end, stats, scratch);
+}
+
+/// @brief Finds the shortest path between two vertices with the cheapest search the edge weights allow, judged from the
+/// graph's cached weight range: breadth-first search if they are all the same, Dial's buckets for small integers,
+/// Dijkstra's algorithm for other non-negative weights, and queue-based Bellman-Ford otherwise. All but Bellman-Ford
+/// stop as soon as the end vertex is settled. Dijkstra's algorithm searches from both ends, over the graph's cached
+/// transpose, unless the view has no owning graph.
+/// @param g The Graph object to check.
+/// @param start The starting vertex.
+/// @param end The end vertex.
+/// @param stats Receives the search used, the vertices it settled and its wall time.
+/// @param scratch Where the distances, parents and queues are allocated.
+/// @return An array of vertices that make up the shortest path.
+template <typename W>
+vector<size_t> Algorithms::shortestPath(const GraphView<W> &g, size_t start, size_t end, QueryStats &stats, pmr::memory_resource *scratch)
+{
+    auto started = chrono::steady_clock::now();
+    WeightRange<W> range = g.weightRange();
+    stats = QueryStats();
+    shared_ptr<const BasicGraph<W>> reversed; // built only for the Bidirectional strategy
+    if (!range.nonNegative())
+    {
+        stats.strategy = PathStrategy::BellmanFord;
+    }
+    else if (range.smallest == range.largest)
+    {
+        stats.strategy = PathStrategy::BreadthFirst;
+    }
+    else if (is_integral<W>::value && size_t(range.largest) <= SMALL_WEIGHT_LIMIT)
+    {
+        stats.strategy = PathStrategy::Buckets;
+    }
+    else
+    {
+        reversed = g.transposed();
+        stats.strategy = reversed != nullptr ? PathStrategy::Bidirectional : PathStrategy::Dijkstra;
+    }
     vector<size_t> path; // Initialize the path vector
 
     // If start = end, return start
     if (start == end)
     {
         path.push_back(start);
+        stats.settled = 1;
+        stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return path;
+    }
+
+    pmr::vector<typename WeightTraits<W>::Accumulator> dist(scratch);
+    pmr::vector<size_t> prev(scratch);
+    switch (stats.strategy)
+    {
+    case PathStrategy::BreadthFirst:
+        stats.settled = breadthFirst(start, end, g, range.largest, dist, prev);
+        break;
+    case PathStrategy::Buckets:
+        stats.settled = dialBuckets(start, end, g, range.largest, dist, prev);
+        break;
+    case PathStrategy::Dijkstra:
+    {
+        ariel::DaryHeap<typename WeightTraits<W>::Accumulator> heap(scratch);
+        stats.settled = dijkstra(start, end, g, nullptr, dist, prev, heap);
+        break;
+    }
+    case PathStrategy::Bidirectional:
+        stats.settled = bidirectionalDijkstra(start, end, g, reversed->view(), path, scratch);
+        stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
         return path;
+    case PathStrategy::BellmanFord:
+        labelCorrecting(start, g, dist, prev);
+        stats.settled = g.getVertices();
+        break;
     }
-    
+
     // If there is a shortest path, build it into path
-    if (prev[end] != INF && dist[end] != NEG_INF)
+    if (dist[end] != WeightTraits<W>::infinity() && dist[end] != WeightTraits<W>::negativeInfinity())
     {
-        for (size_t at = end; at != INF; at = prev[at])
+        for (size_t at = end; at != start; at = prev[at])
         {
             path.push_back(at);
         }
+        path.push_back(start);
         reverse(path.begin(), path.end());
     }
 
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
     return path;
 }
 
 /// @brief Checks if the graph contains any cycles.
 /// @param g The Graph object to check.
+/// @param scratch Where the search state is allocated.
 /// @return True if the graph contains a cycle, false otherwise.
-bool Algorithms::isContainsCycle(const Graph &g)
+template <typename W>
+bool Algorithms::isContainsCycle(const GraphView<W> &g, pmr::memory_resource *scratch)
 {
-    const vector<vector<int>> &graph = g.getGraph();
+    if (g.getRepresentation() == Representation::Dense)
+    {
+        bool cycle = containsCycle(*g.adjacencyBits(scratch), scratch);
+        cout << (cycle ? "Cycle detected!" : "No cycle detected!") << endl;
+        return cycle;
+    }
+
     size_t n = g.getVertices();
-    vector<bool> visited(n, false);
-    vector<bool> recStack(n, false);
-    vector<size_t> parent(n, INF);
+    pmr::vector<bool> visited(n, false, scratch);
+    pmr::vector<bool> recStack(n, false, scratch);
+    pmr::vector<size_t> parent(n, INF, scratch);
 
     // Check for cycles using DFS
     for (size_t i = 0; i < n; ++i)
     {
         if (!visited[i])
         {
-            if (dfs(i, visited, recStack, graph, parent))
+            if (dfs(i, visited, recStack, g, parent))
             {
                 cout << "Cycle detected!" << endl;
                 return true; // Cycle detected
@@ -275,35 +958,65 @@ bool Algorithms::isContainsCycle(const Graph &g)
 
 /// @brief Checks if a graph is bipartite.
 /// @param g The Graph object to check.
+/// @param scratch Where the colors, queues and groups are allocated.
 /// @return True if the graph is bipartite, false otherwise.
-bool Algorithms::isBipartite(const Graph &g)
+template <typename W>
+bool Algorithms::isBipartite(const GraphView<W> &g, pmr::memory_resource *scratch)
 {
-    const vector<vector<int>> &graph = g.getGraph();
     size_t n = g.getVertices();
-    vector<vector<size_t>> groups;
-    vector<size_t> colors(n, INF); // Initialize colors, INF indicates uncolored
+    pmr::vector<size_t> colors(n, INF, scratch); // Initialize colors, INF indicates uncolored
+    pmr::vector<size_t> rounds(n, INF, scratch); // Which search, one per uncolored start vertex, colored each vertex
+    size_t searches = 0;
 
-    // Check each vertex in the graph
-    for (size_t i = 0; i < n; ++i)
+    if (g.getRepresentation() == Representation::Dense)
     {
-        if (colors[i] == INF)
-        {                                                        // Vertex not visited yet
-            if (!isComponentBipartite(i, graph, colors, groups)) // Check specific vertex
-            {
-                cout << "Graph is not Bipartite!" << endl;
-                return false; // Not bipartite
+        if (!isBipartite(*g.adjacencyBits(scratch), colors, rounds))
+        {
+            cout << "Graph is not Bipartite!" << endl;
+            return false; // Not bipartite
+        }
+        for (size_t v = 0; v < n; ++v)
+        {
+            searches = max(searches, rounds[v] + 1);
+        }
+    }
+    else
+    {
+        // Check each vertex in the graph
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (colors[i] == INF)
+            {                                            // Vertex not visited yet
+                if (!isComponentBipartite(i, g, colors)) // Check specific vertex
+                {
+                    cout << "Graph is not Bipartite!" << endl;
+                    return false; // Not bipartite
+                }
+                // Every vertex this search colored comes after its start, which was the first uncolored one
+                for (size_t v = i; v < n; ++v)
+                {
+                    if (colors[v] != INF && rounds[v] == INF)
+                    {
+                        rounds[v] = searches;
+                    }
+                }
+                ++searches;
             }
         }
     }
 
-    // Print the groups
+    // Print the groups: after each search, the vertices colored 0 so far and all the others
     cout << "Graph is Bipartite! These are the possible groups:" << endl;
-    for (size_t i = 0; i < groups.size(); i++)
+    for (size_t i = 0; i < 2 * searches; i++)
     {
         cout << "Group " << (i % 2) + 1 << ": ";
-        for (size_t vertex : groups[i])
+        for (size_t vertex = 0; vertex < n; ++vertex)
         {
-            cout << vertex << " ";
+            bool first = rounds[vertex] <= i / 2 && colors[vertex] == 0;
+            if (first == (i % 2 == 0))
+            {
+                cout << vertex << " ";
+            }
         }
         cout << endl;
     }
@@ -313,24 +1026,478 @@ bool Algorithms::isBipartite(const Graph &g)
 
 /// @brief Checks for the presence of any negative weight cycles in the graph.
 /// @param g The Graph object containing the adjacency matrix and vertex count.
+/// @param scratch Where the distances and parents are allocated.
 /// @return True if any negative weight cycle is found, false otherwise.
-bool Algorithms::negativeCycle(const Graph &g)
+template <typename W>
+bool Algorithms::negativeCycle(const GraphView<W> &g, pmr::memory_resource *scratch)
+{
+    if (!findNegativeCycle(g, scratch).empty())
+    {
+        cout << "Negative cycle detected!" << endl;
+        return true; // Negative cycle found
+    }
+
+    cout << "No negative cycle detected!" << endl;
+    return false; // No negative cycle found
+}
+
+/// @brief Finds a negative weight cycle with one Bellman-Ford pass from a virtual vertex joined to every vertex by a
+/// zero-weight edge, so that a cycle anywhere in the graph is found without a pass from every vertex.
+/// The pass stops as soon as the predecessors contain a cycle, which is always a negative cycle.
+/// @param g The graph.
+/// @param scratch Where the distances, parents and walks are allocated.
+/// @return The vertices of the cycle in the order of its edges, or an empty vector if there is none.
+template <typename W>
+vector<size_t> Algorithms::findNegativeCycle(const GraphView<W> &g, pmr::memory_resource *scratch)
+{
+    size_t n = g.getVertices();
+    pmr::vector<typename WeightTraits<W>::Accumulator> distance(scratch);
+    pmr::vector<size_t> parent(scratch);
+    vector<size_t> cycle;
+    if (n == 0 || !bellmanFord(EVERY_VERTEX, g, distance, parent, false))
+    {
+        return cycle;
+    }
+
+    pmr::vector<size_t> walk(scratch);
+    size_t v = findParentCycle(parent, walk);
+    size_t u = v;
+    do
+    {
+        cycle.push_back(u);
+        u = parent[u];
+    } while (u != v);
+    // The predecessors list the cycle backwards
+    reverse(cycle.begin(), cycle.end());
+    return cycle;
+}
+
+/// @brief Finds the strongly connected components with an iterative Tarjan search.
+/// Components are numbered in reverse topological order: every edge leaving a component leads to one with a smaller number.
+/// @param graph The graph being searched.
+/// @param component Receives the component of each vertex.
+/// @param members Receives the vertices grouped by component.
+/// @param firstMember Receives where each component starts in members, followed by members.size().
+/// @return The number of components.
+template <typename W>
+size_t Algorithms::strongComponents(const GraphView<W> &graph, pmr::vector<size_t> &component, pmr::vector<size_t> &members, pmr::vector<size_t> &firstMember)
+{
+    struct Frame
+    {
+        size_t vertex;
+        NeighborIterator<W> next;
+        NeighborIterator<W> last;
+    };
+    const size_t UNVISITED = numeric_limits<size_t>::max();
+    size_t n = graph.getVertices();
+    pmr::memory_resource *scratch = component.get_allocator().resource();
+    pmr::vector<size_t> index(n, UNVISITED, scratch);
+    pmr::vector<size_t> low(n, 0, scratch);
+    pmr::vector<size_t> open(scratch); // visited vertices whose component is not known yet
+    pmr::vector<Frame> stack(scratch);
+    component.assign(n, UNVISITED);
+    members.clear();
+    firstMember.clear();
+    size_t counter = 0;
+
+    for (size_t start = 0; start < n; ++start)
+    {
+        if (index[start] != UNVISITED)
+        {
+            continue;
+        }
+        index[start] = low[start] = counter++;
+        open.push_back(start);
+        NeighborRange<W> edges = graph.neighbors(start);
+        stack.push_back({start, edges.begin(), edges.end()});
+        while (!stack.empty())
+        {
+            Frame &top = stack.back();
+            size_t v = top.vertex;
+            if (top.next != top.last)
+            {
+                size_t w = (*top.next).to;
+                ++top.next;
+                if (index[w] == UNVISITED)
+                {
+                    index[w] = low[w] = counter++;
+                    open.push_back(w);
+                    edges = graph.neighbors(w);
+                    stack.push_back({w, edges.begin(), edges.end()});
+                }
+                else if (component[w] == UNVISITED)
+                {
+                    low[v] = min(low[v], index[w]);
+                }
+                continue;
+            }
+            stack.pop_back();
+            if (!stack.empty())
+            {
+                size_t parent = stack.back().vertex;
+                low[parent] = min(low[parent], low[v]);
+            }
+            if (low[v] == index[v])
+            {
+                firstMember.push_back(members.size());
+                size_t w;
+                do
+                {
+                    w = open.back();
+                    open.pop_back();
+                    component[w] = firstMember.size() - 1;
+                    members.push_back(w);
+                } while (w != v);
+            }
+        }
+    }
+    firstMember.push_back(members.size());
+    return firstMember.size() - 1;
+}
+
+/// @brief Computes all-pairs reachability on the condensation of the graph.
+/// Components are processed sinks first, so the reachability row of every component a component has edges to is
+/// already complete: its row is the union, 64 vertices per word, of the targets of its edges and their rows. Targets
+/// are merged closest first and skipped once already reached, since their rows are then already included. All the
+/// members of a component share its row.
+/// @param g The graph.
+/// @param scratch Where the components and the edge targets are allocated; the result is allocated normally.
+/// @return The bit-packed reachability matrix.
+template <typename W>
+BitMatrix Algorithms::transitiveClosure(const GraphView<W> &g, pmr::memory_resource *scratch)
+{
+    size_t n = g.getVertices();
+    pmr::vector<size_t> component(scratch);
+    pmr::vector<size_t> members(scratch);
+    pmr::vector<size_t> firstMember(scratch);
+    size_t components = strongComponents(g, component, members, firstMember);
+    BitMatrix reach(n);
+    size_t words = reach.wordsPerRow();
+    pmr::vector<size_t> targets(scratch);
+
+    for (size_t c = 0; c < components; ++c)
+    {
+        size_t leader = members[firstMember[c]];
+        uint64_t *row = reach.row(leader);
+        targets.clear();
+        for (size_t m = firstMember[c]; m < firstMember[c + 1]; ++m)
+        {
+            for (Edge<W> edge : g.neighbors(members[m]))
+            {
+                if (component[edge.to] == c)
+                {
+                    reach.set(leader, edge.to);
+                }
+                else
+                {
+                    targets.push_back(edge.to);
+                }
+            }
+        }
+        sort(targets.begin(), targets.end(), [&](size_t a, size_t b)
+             { return component[a] > component[b]; });
+        for (size_t w : targets)
+        {
+            if (!reach.test(leader, w))
+            {
+                reach.set(leader, w);
+                ariel::simd::orInto(row, reach.row(members[firstMember[component[w]]]), words);
+            }
+        }
+        for (size_t m = firstMember[c] + 1; m < firstMember[c + 1]; ++m)
+        {
+            copy(row, row + words, reach.row(members[m]));
+        }
+    }
+    return reach;
+}
+
+// Side of the square blocks Floyd-Warshall works on: three blocks of 64-bit distances fit in L2
+static const size_t FLOYD_BLOCK = 64;
+
+/// @brief Computes all-pairs shortest paths with the blocked Floyd-Warshall algorithm.
+/// The matrix is split into FLOYD_BLOCK x FLOYD_BLOCK blocks. For each block k of intermediate vertices, the diagonal
+/// block is relaxed first, then the other blocks of row k and column k (which only depend on themselves and the
+/// diagonal block), in parallel, then every remaining block (which only depends on its row k and column k blocks),
+/// in parallel. Both parallel steps are one parallelFor each, run on its worker pool, so the 2 * n / FLOYD_BLOCK of
+/// them start no threads. Every step relaxes a run of a row through one vertex with simd::relaxThrough. Relaxing a row
+/// through its own vertex is skipped: it only shortens a path through a negative cycle, and such paths are marked
+/// afterwards.
+/// The vertices whose distance to themselves ends up negative are on negative cycles; every pair with a path through
+/// one of them gets negativeInfinity().
+/// @param g The graph.
+/// @param withNextHops Whether to record the first hop of each shortest path.
+/// @param scratch Where the negative cycle bookkeeping is allocated; the result is allocated normally.
+/// @return The distances and next hops.
+template <typename W>
+PathMatrix<W> Algorithms::allPairsShortestPaths(const GraphView<W> &g, bool withNextHops, pmr::memory_resource *scratch)
 {
-    const vector<vector<int>> &graph = g.getGraph();
+    using Distance = typename PathMatrix<W>::Distance;
+    const Distance infinity = WeightTraits<W>::infinity();
     size_t n = g.getVertices();
-    vector<int> distance;
-    vector<size_t> parent;
+    PathMatrix<W> paths(n, withNextHops);
+    Distance *distance = paths.distances.data();
+    size_t *next = withNextHops ? paths.hops.data() : nullptr;
 
-    // Check for negative cycles from each vertex
+    Distance largest = 0; // the largest weight magnitude, with lowest() counted as max()
     for (size_t i = 0; i < n; ++i)
     {
-        if (bellmanFord(i, graph, distance, parent))
+        distance[i * n + i] = 0;
+        if (next != nullptr)
         {
-            cout << "Negative cycle detected!" << endl;
-            return true; // Negative cycle found
+            next[i * n + i] = i;
+        }
+        for (Edge<W> edge : g.neighbors(i))
+        {
+            Distance weight = Distance(edge.weight);
+            largest = max(largest, weight < 0 ? -max(weight, -numeric_limits<Distance>::max()) : weight);
+            if (weight < distance[i * n + edge.to])
+            {
+                distance[i * n + edge.to] = weight;
+                if (next != nullptr)
+                {
+                    next[i * n + edge.to] = edge.to;
+                }
+            }
         }
     }
 
-    cout << "No negative cycle detected!" << endl;
-    return false; // No negative cycle found
+    // Every distance is at most the length of a simple path, n * largest, and at least the clamp at lowest() / 4,
+    // so no sum of two can overflow while n * largest stays within lowest() / 4. Otherwise every sum is checked.
+    bool checked = false;
+    if constexpr (is_integral<Distance>::value)
+    {
+        Distance bound;
+        checked = __builtin_mul_overflow(largest, Distance(n), &bound) || bound > -(numeric_limits<Distance>::lowest() / 4);
+    }
+    atomic<bool> overflowed(false);
+    // Relaxes columns [first, last) of row i through vertex k
+    auto relax = [&](size_t i, size_t k, size_t first, size_t last)
+    {
+        Distance through = distance[i * n + k];
+        if (through == infinity || first >= last)
+        {
+            return;
+        }
+        Distance *row = distance + i * n + first;
+        const Distance *onward = distance + k * n + first;
+        size_t *hops = next != nullptr ? next + i * n + first : nullptr;
+        size_t hop = next != nullptr ? next[i * n + k] : 0;
+        bool wrapped = false;
+        if (!checked && hops != nullptr)
+        {
+            ariel::simd::relaxThrough(row, through, onward, hops, hop, last - first);
+        }
+        else if (!checked)
+        {
+            ariel::simd::relaxThrough(row, through, onward, last - first);
+        }
+        else if (hops != nullptr)
+        {
+            wrapped = ariel::simd::relaxThroughChecked(row, through, onward, hops, hop, last - first);
+        }
+        else
+        {
+            wrapped = ariel::simd::relaxThroughChecked(row, through, onward, last - first);
+        }
+        if (wrapped)
+        {
+            overflowed.store(true, memory_order_relaxed);
+        }
+    };
+    size_t blocks = (n + FLOYD_BLOCK - 1) / FLOYD_BLOCK;
+    auto blockEnd = [&](size_t b)
+    { return min(n, (b + 1) * FLOYD_BLOCK); };
+
+    for (size_t kb = 0; kb < blocks; ++kb)
+    {
+        size_t k0 = kb * FLOYD_BLOCK;
+        size_t k1 = blockEnd(kb);
+        for (size_t k = k0; k < k1; ++k)
+        {
+            for (size_t i = k0; i < k1; ++i)
+            {
+                if (i != k)
+                {
+                    relax(i, k, k0, k1);
+                }
+            }
+        }
+        parallelFor(0, blocks, [&](size_t begin, size_t end)
+                    {
+                        for (size_t b = begin; b < end; ++b)
+                        {
+                            if (b == kb)
+                            {
+                                continue;
+                            }
+                            size_t b0 = b * FLOYD_BLOCK;
+                            size_t b1 = blockEnd(b);
+                            for (size_t k = k0; k < k1; ++k)
+                            {
+                                for (size_t i = k0; i < k1; ++i)
+                                {
+                                    if (i != k)
+                                    {
+                                        relax(i, k, b0, b1);
+                                    }
+                                }
+                                for (size_t i = b0; i < b1; ++i)
+                                {
+                                    relax(i, k, k0, k1);
+                                }
+                            }
+                        } });
+        parallelFor(0, blocks, [&](size_t begin, size_t end)
+                    {
+                        for (size_t ib = begin; ib < end; ++ib)
+                        {
+                            if (ib == kb)
+                            {
+                                continue;
+                            }
+                            for (size_t jb = 0; jb < blocks; ++jb)
+                            {
+                                if (jb == kb)
+                                {
+                                    continue;
+                                }
+                                for (size_t i = ib * FLOYD_BLOCK; i < blockEnd(ib); ++i)
+                                {
+                                    for (size_t k = k0; k < k1; ++k)
+                                    {
+                                        relax(i, k, jb * FLOYD_BLOCK, blockEnd(jb));
+                                    }
+                                }
+                            }
+                        } });
+    }
+
+    if (overflowed)
+    {
+        throw overflow_error("A path length overflows 64-bit integers");
+    }
+
+    pmr::vector<size_t> negative(scratch);
+    for (size_t v = 0; v < n; ++v)
+    {
+        if (distance[v * n + v] < 0)
+        {
+            negative.push_back(v);
+        }
+    }
+    if (negative.empty())
+    {
+        return paths;
+    }
+    paths.negative = true;
+
+    // Bit j of row t is set iff negative[t] reaches j; row i is then marked on the union of the rows it reaches
+    size_t words = (n + BitMatrix::WORD_BITS - 1) / BitMatrix::WORD_BITS;
+    pmr::vector<uint64_t> reached(negative.size() * words, 0, scratch);
+    for (size_t t = 0; t < negative.size(); ++t)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            if (distance[negative[t] * n + j] != infinity)
+            {
+                reached[t * words + j / BitMatrix::WORD_BITS] |= uint64_t(1) << (j % BitMatrix::WORD_BITS);
+            }
+        }
+    }
+    parallelFor(0, n, [&](size_t begin, size_t end)
+                {
+                    pmr::vector<uint64_t> marked(words, pmr::new_delete_resource());
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        fill(marked.begin(), marked.end(), 0);
+                        for (size_t t = 0; t < negative.size(); ++t)
+                        {
+                            if (distance[i * n + negative[t]] != infinity)
+                            {
+                                ariel::simd::orInto(marked.data(), reached.data() + t * words, words);
+                            }
+                        }
+                        for (size_t w = 0; w < words; ++w)
+                        {
+                            for (uint64_t bits = marked[w]; bits != 0; bits &= bits - 1)
+                            {
+                                size_t j = w * BitMatrix::WORD_BITS + lowestBit(bits);
+                                distance[i * n + j] = WeightTraits<W>::negativeInfinity();
+                                if (next != nullptr)
+                                {
+                                    next[i * n + j] = PathMatrix<W>::NO_VERTEX;
+                                }
+                            }
+                        }
+                    } },
+                FLOYD_BLOCK);
+    return paths;
 }
+
+/// @brief Computes all-pairs shortest paths with Johnson's algorithm.
+/// Queue-based Bellman-Ford from a virtual vertex joined to every vertex by a zero-weight edge gives each vertex a
+/// potential h, its distance from that vertex, such that every edge (u, v) weighs at least h[v] - h[u]. Adding
+/// h[u] - h[v] to each edge makes them all non-negative without changing which paths are shortest, so Dijkstra can run
+/// from every source; the true distance from s to v is then the adjusted one minus h[s] - h[v]. The sources are split
+/// between threads.
+/// @param g The graph.
+/// @param visit Receives the distances and parents of each source.
+/// @param scratch Where the potentials are allocated; the per-source state of each thread is allocated normally.
+/// @return True if the paths were computed, false if the graph has a negative cycle.
+template <typename W>
+bool Algorithms::johnsonShortestPaths(const GraphView<W> &g, const SourcePaths<W> &visit, pmr::memory_resource *scratch)
+{
+    using Distance = typename WeightTraits<W>::Accumulator;
+    size_t n = g.getVertices();
+    if (n == 0)
+    {
+        return true;
+    }
+    pmr::vector<Distance> potential(scratch);
+    pmr::vector<size_t> unused(scratch);
+    if (labelCorrecting(EVERY_VERTEX, g, potential, unused, false))
+    {
+        return false;
+    }
+
+    parallelFor(0, n, [&](size_t begin, size_t end)
+                {
+                    pmr::memory_resource *local = pmr::new_delete_resource();
+                    pmr::vector<Distance> distance(local);
+                    pmr::vector<size_t> parent(local);
+                    ariel::DaryHeap<Distance> heap(local);
+                    for (size_t s = begin; s < end; ++s)
+                    {
+                        dijkstra(s, PathMatrix<W>::NO_VERTEX, g, potential.data(), distance, parent, heap);
+                        for (size_t v = 0; v < n; ++v)
+                        {
+                            if (distance[v] != WeightTraits<W>::infinity())
+                            {
+                                distance[v] = WeightTraits<W>::subtract(distance[v], WeightTraits<W>::subtract(potential[s], potential[v]));
+                            }
+                        }
+                        visit(s, distance.data(), parent.data());
+                    } });
+    return true;
+}
+
+// The supported weight types
+#define ARIEL_INSTANTIATE_ALGORITHMS(W)                                                                                   \
+    template bool Algorithms::isConnected<W>(const GraphView<W> &, pmr::memory_resource *);                            \
+    template vector<size_t> Algorithms::shortestPath<W>(const GraphView<W> &, size_t, size_t, pmr::memory_resource *); \
+    template vector<size_t> Algorithms::shortestPath<W>(const GraphView<W> &, size_t, size_t, ariel::QueryStats &, pmr::memory_resource *); \
+    template bool Algorithms::isContainsCycle<W>(const GraphView<W> &, pmr::memory_resource *);                        \
+    template bool Algorithms::isBipartite<W>(const GraphView<W> &, pmr::memory_resource *);                            \
+    template bool Algorithms::negativeCycle<W>(const GraphView<W> &, pmr::memory_resource *);                          \
+    template vector<size_t> Algorithms::findNegativeCycle<W>(const GraphView<W> &, pmr::memory_resource *);            \
+    template BitMatrix Algorithms::transitiveClosure<W>(const GraphView<W> &, pmr::memory_resource *);                 \
+    template PathMatrix<W> Algorithms::allPairsShortestPaths<W>(const GraphView<W> &, bool, pmr::memory_resource *);   \
+    template bool Algorithms::johnsonShortestPaths<W>(const GraphView<W> &, const ariel::SourcePaths<W> &, pmr::memory_resource *);
+
+ARIEL_INSTANTIATE_ALGORITHMS(int8_t)
+ARIEL_INSTANTIATE_ALGORITHMS(int16_t)
+ARIEL_INSTANTIATE_ALGORITHMS(int32_t)
+ARIEL_INSTANTIATE_ALGORITHMS(int64_t)
+ARIEL_INSTANTIATE_ALGORITHMS(float)
+ARIEL_INSTANTIATE_ALGORITHMS(double)
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "DaryHeap.hpp"
 #include "Graph.hpp"
+#include "GraphView.hpp"
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <memory_resource>
 #include <queue>
 
 using namespace std;
@@ -13,19 +17,182 @@ const int NEG_INF = numeric_limits<int>::min();
 
 namespace ariel
 {
+    /// @brief The result of Algorithms::allPairsShortestPaths: the distance between every pair of vertices and,
+    /// when requested, the first hop of a shortest path, as n x n row-major matrices.
+    template <typename W>
+    class PathMatrix
+    {
+    public:
+        using Distance = typename WeightTraits<W>::Accumulator;
+        static constexpr size_t NO_VERTEX = numeric_limits<size_t>::max();
+
+        PathMatrix() = default;
+        size_t getVertices() const { return vertices; }
+        bool hasNextHops() const { return !hops.empty() || vertices == 0; }
+        bool hasNegativeCycle() const { return negative; }
+        /// @brief The length of a shortest path: WeightTraits<W>::infinity() if there is none, and
+        /// WeightTraits<W>::negativeInfinity() if a path can go around a negative cycle.
+        Distance distance(size_t from, size_t to) const { return distances[from * vertices + to]; }
+        /// @brief The distances, row-major.
+        const Distance *data() const { return distances.data(); }
+
+        /// @brief The vertex after from on a shortest path to to (from itself when to == from), or NO_VERTEX if the
+        /// distance is infinite. Throws unless the next hops were requested.
+        size_t nextHop(size_t from, size_t to) const
+        {
+            if (!hasNextHops())
+            {
+                throw runtime_error("The next hops were not recorded");
+            }
+            return hops[from * vertices + to];
+        }
+
+        /// @brief The vertices of a shortest path from from to to, both included; empty if the distance is infinite.
+        vector<size_t> path(size_t from, size_t to) const
+        {
+            vector<size_t> vertexPath;
+            if (nextHop(from, to) == NO_VERTEX)
+            {
+                return vertexPath;
+            }
+            vertexPath.push_back(from);
+            for (size_t v = from; v != to;)
+            {
+                v = hops[v * vertices + to];
+                vertexPath.push_back(v);
+            }
+            return vertexPath;
+        }
+
+    private:
+        friend class Algorithms;
+        size_t vertices = 0;
+        bool negative = false;
+        Buffer<Distance> distances;
+        Buffer<size_t> hops; // empty unless requested
+
+        PathMatrix(size_t vertices, bool withNextHops)
+            : vertices(vertices), distances(vertices * vertices, WeightTraits<W>::infinity()),
+              hops(withNextHops ? vertices * vertices : 0, NO_VERTEX)
+        {
+        }
+    };
+
+    /// @brief The search Algorithms::shortestPath used, picked from the graph's weight range.
+    enum class PathStrategy
+    {
+        BreadthFirst,  // every edge weighs the same: breadth-first search
+        Buckets,       // integral weights from 1 to Algorithms::SMALL_WEIGHT_LIMIT: Dial's bucket queue
+        Dijkstra,      // any other non-negative weights, on a view without an owning graph to transpose
+        Bidirectional, // any other non-negative weights: Dijkstra's algorithm from both ends on the cached transpose
+        BellmanFord    // some weight is negative: queue-based Bellman-Ford
+    };
+
+    /// @brief What one shortestPath query did.
+    struct QueryStats
+    {
+        PathStrategy strategy = PathStrategy::BellmanFord;
+        size_t settled = 0; // vertices whose distance was final when the search stopped (all of them for Bellman-Ford)
+        double seconds = 0; // wall time of the query
+    };
+
+    /// @brief Receives the shortest paths from one source (see Algorithms::johnsonShortestPaths): the distance to every
+    /// vertex (WeightTraits<W>::infinity() if unreachable) and the vertex before it on a shortest path (PathMatrix<W>::NO_VERTEX
+    /// for the source and unreachable vertices). Both arrays have one entry per vertex and are only valid during the call.
+    template <typename W>
+    using SourcePaths = function<void(size_t source, const typename WeightTraits<W>::Accumulator *distance, const size_t *parent)>;
+
+    /// @brief The graph algorithms. Every algorithm takes an optional memory resource for its scratch state (visited sets, stacks,
+    /// queues, distances); pass an arena to keep a request off the global heap. The resource is only
+    /// used by the calling thread, so a std::pmr::monotonic_buffer_resource needs no locking.
+    /// Path lengths are summed in WeightTraits<W>::Accumulator; with int64_t weights a length that does not fit
+    /// throws overflow_error.
     class Algorithms
     {
     private:
-        static bool dfs(size_t v, vector<bool> &visited, vector<bool> &recStack, const vector<vector<int>> &graph, vector<size_t> &parent);
-        static bool isComponentBipartite(size_t start, const vector<vector<int>> &graph, vector<size_t> &colors, vector<vector<size_t>> &groups);
-        static bool bellmanFord(size_t start, const vector<vector<int>> &graph, vector<int> &distance, vector<size_t> &parent);
-    
+        template <typename W>
+        static bool dfs(size_t v, pmr::vector<bool> &visited, pmr::vector<bool> &recStack, const GraphView<W> &graph, pmr::vector<size_t> &parent);
+        template <typename W>
+        static bool isComponentBipartite(size_t start, const GraphView<W> &graph, pmr::vector<size_t> &colors);
+        static bool reachesAll(const BitMatrix &adjacency, pmr::memory_resource *scratch);
+        static bool containsCycle(const BitMatrix &adjacency, pmr::memory_resource *scratch);
+        static bool isBipartite(const BitMatrix &adjacency, pmr::vector<size_t> &colors, pmr::vector<size_t> &rounds);
+        template <typename W>
+        static size_t strongComponents(const GraphView<W> &graph, pmr::vector<size_t> &component, pmr::vector<size_t> &members, pmr::vector<size_t> &firstMember);
+        // Start vertex of bellmanFord standing for a virtual source with a zero-weight edge to every vertex
+        static constexpr size_t EVERY_VERTEX = numeric_limits<size_t>::max();
+        template <typename W>
+        static size_t dijkstra(size_t start, size_t target, const GraphView<W> &graph, const typename WeightTraits<W>::Accumulator *potential, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent, DaryHeap<typename WeightTraits<W>::Accumulator> &heap);
+        template <typename W>
+        static size_t bidirectionalDijkstra(size_t start, size_t target, const GraphView<W> &graph, const GraphView<W> &reversed, vector<size_t> &path, pmr::memory_resource *scratch);
+        template <typename W>
+        static size_t breadthFirst(size_t start, size_t target, const GraphView<W> &graph, W weight, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent);
+        template <typename W>
+        static size_t dialBuckets(size_t start, size_t target, const GraphView<W> &graph, W largest, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent);
+        template <typename W>
+        static bool labelCorrecting(size_t start, const GraphView<W> &graph, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent, bool markUnbounded = true);
+        template <typename W>
+        static bool bellmanFord(size_t start, const GraphView<W> &graph, pmr::vector<typename WeightTraits<W>::Accumulator> &distance, pmr::vector<size_t> &parent, bool markUnbounded = true);
+
     public:
-        static bool isConnected(const Graph &g);
-        static vector<size_t> shortestPath(const Graph &g, size_t start, size_t end);
-        static bool isContainsCycle(const Graph &g);
-        static bool isBipartite(const Graph &g);
-        static bool negativeCycle(const Graph &g);
+        // Largest integral weight for which shortestPath uses a bucket queue, one bucket per distance modulo it + 1
+        static constexpr size_t SMALL_WEIGHT_LIMIT = 64;
+
+        // Defined in Algorithms.cpp for every weight type BasicGraph supports
+        template <typename W>
+        static bool isConnected(const GraphView<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource());
+        template <typename W>
+        static vector<size_t> shortestPath(const GraphView<W> &g, size_t start, size_t end, pmr::memory_resource *scratch = pmr::get_default_resource());
+        /// @brief shortestPath, also reporting which search it used and how many vertices it settled.
+        template <typename W>
+        static vector<size_t> shortestPath(const GraphView<W> &g, size_t start, size_t end, QueryStats &stats, pmr::memory_resource *scratch = pmr::get_default_resource());
+        template <typename W>
+        static bool isContainsCycle(const GraphView<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource());
+        template <typename W>
+        static bool isBipartite(const GraphView<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource());
+        template <typename W>
+        static bool negativeCycle(const GraphView<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource());
+        /// @brief A negative cycle anywhere in the graph, found by a single Bellman-Ford pass (O(n * m)): its vertices in the
+        /// order its edges go, the last one back to the first, or an empty vector if there is none.
+        template <typename W>
+        static vector<size_t> findNegativeCycle(const GraphView<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource());
+        /// @brief All-pairs reachability: bit (i, j) of the result is set iff there is a path of at least one edge
+        /// from i to j (so (i, i) is set iff i is on a cycle). Takes n^2 / 8 bytes and O(n + m * n / 64) time.
+        template <typename W>
+        static BitMatrix transitiveClosure(const GraphView<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource());
+        /// @brief The distance between every pair of vertices, by blocked Floyd-Warshall (O(n^3) time, n^2 distances, and
+        /// as many next hops if withNextHops). Negative edges are allowed; pairs joined by a path through a negative cycle
+        /// get negativeInfinity().
+        template <typename W>
+        static PathMatrix<W> allPairsShortestPaths(const GraphView<W> &g, bool withNextHops = false, pmr::memory_resource *scratch = pmr::get_default_resource());
+        /// @brief All-pairs shortest paths by Johnson's algorithm, O(n * m log n) time, for sparse graphs with negative edges:
+        /// one Bellman-Ford pass computes vertex potentials that make every edge non-negative, then Dijkstra runs from every
+        /// source in parallel and hands each source's paths to visit, so only O(n) memory per thread is ever held. visit is
+        /// called once per source, concurrently from several threads. Returns false, without calling visit, if the graph
+        /// has a negative cycle.
+        template <typename W>
+        static bool johnsonShortestPaths(const GraphView<W> &g, const SourcePaths<W> &visit, pmr::memory_resource *scratch = pmr::get_default_resource());
+
+        template <typename W>
+        static bool isConnected(const BasicGraph<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource()) { return isConnected(g.view(), scratch); }
+        template <typename W>
+        static vector<size_t> shortestPath(const BasicGraph<W> &g, size_t start, size_t end, pmr::memory_resource *scratch = pmr::get_default_resource()) { return shortestPath(g.view(), start, end, scratch); }
+        template <typename W>
+        static vector<size_t> shortestPath(const BasicGraph<W> &g, size_t start, size_t end, QueryStats &stats, pmr::memory_resource *scratch = pmr::get_default_resource()) { return shortestPath(g.view(), start, end, stats, scratch); }
+        template <typename W>
+        static bool isContainsCycle(const BasicGraph<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource()) { return isContainsCycle(g.view(), scratch); }
+        template <typename W>
+        static bool isBipartite(const BasicGraph<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource()) { return isBipartite(g.view(), scratch); }
+        template <typename W>
+        static bool negativeCycle(const BasicGraph<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource()) { return negativeCycle(g.view(), scratch); }
+        template <typename W>
+        static vector<size_t> findNegativeCycle(const BasicGraph<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource()) { return findNegativeCycle(g.view(), scratch); }
+        template <typename W>
+        static BitMatrix transitiveClosure(const BasicGraph<W> &g, pmr::memory_resource *scratch = pmr::get_default_resource()) { return transitiveClosure(g.view(), scratch); }
+        template <typename W>
+        static PathMatrix<W> allPairsShortestPaths(const BasicGraph<W> &g, bool withNextHops = false, pmr::memory_resource *scratch = pmr::get_default_resource()) { return allPairsShortestPaths(g.view(), withNextHops, scratch); }
+        template <typename W>
+        static bool johnsonShortestPaths(const BasicGraph<W> &g, const SourcePaths<W> &visit, pmr::memory_resource *scratch = pmr::get_default_resource()) { return johnsonShortestPaths(g.view(), visit, scratch); }
     };
 
 } // namespace ariel
\ No newline at end of file
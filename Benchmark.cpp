@@ -0,0 +1,172 @@
+/*
+ * Throughput of the elementwise Graph operators.
+ * Every operator is timed against the same operation on a nested vector<vector<int>> matrix,
+ * written the way Graph.cpp implemented it before graphs had contiguous storage and SIMD kernels.
+ * Usage: ./bench [vertices]
+ */
+
+#include "Graph.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+using ariel::Graph;
+using namespace std;
+
+namespace
+{
+    using Matrix = vector<vector<int>>;
+    const size_t DEFAULT_VERTICES = 2048;
+    const int REPEATS = 10;
+
+    // Average wall time of one call, after one untimed warm-up call
+    template <typename Operation>
+    double secondsPerCall(Operation operation)
+    {
+        operation();
+        auto started = chrono::steady_clock::now();
+        for (int r = 0; r < REPEATS; ++r)
+        {
+            operation();
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - started).count() / REPEATS;
+    }
+
+    // bytes is the matrix traffic of one call: every matrix read plus the one written
+    void report(const char *name, double bytes, double graphSeconds, double nestedSeconds)
+    {
+        printf("%-14s %10.2f %10.2f %8.1fx\n", name, bytes / graphSeconds / 1e9, bytes / nestedSeconds / 1e9,
+               nestedSeconds / graphSeconds);
+    }
+
+    Matrix randomMatrix(size_t n, unsigned seed)
+    {
+        mt19937 random(seed);
+        uniform_int_distribution<int> weight(1, 100);
+        Matrix matrix(n, vector<int>(n));
+        for (auto &row : matrix)
+        {
+            for (int &value : row)
+            {
+                value = weight(random);
+            }
+        }
+        return matrix;
+    }
+
+    // The pre-SIMD implementations: a new nested matrix filled element by element and then
+    // copied into the result graph, or an in-place element by element update
+    Matrix nestedAdd(Matrix &graph, const Matrix &other)
+    {
+        Matrix adjMat(graph.size(), vector<int>(graph.size(), 0));
+        for (size_t i = 0; i < graph.size(); ++i)
+        {
+            for (size_t j = 0; j < graph[i].size(); ++j)
+            {
+                adjMat[i][j] = graph[i][j] + other[i][j];
+            }
+        }
+        Matrix result = adjMat;
+        return result;
+    }
+
+    Matrix nestedSubtract(Matrix &graph, const Matrix &other)
+    {
+        Matrix adjMat(graph.size(), vector<int>(graph.size(), 0));
+        for (size_t i = 0; i < graph.size(); ++i)
+        {
+            for (size_t j = 0; j < graph[i].size(); ++j)
+            {
+                adjMat[i][j] = graph[i][j] -= other[i][j];
+            }
+        }
+        Matrix result = adjMat;
+        return result;
+    }
+
+    void nestedAddScalar(Matrix &graph, int num)
+    {
+        for (size_t i = 0; i < graph.size(); ++i)
+        {
+            for (size_t j = 0; j < graph[i].size(); ++j)
+            {
+                graph[i][j] += num;
+            }
+        }
+    }
+
+    void nestedScale(Matrix &graph, int num)
+    {
+        for (size_t i = 0; i < graph.size(); ++i)
+        {
+            for (size_t j = 0; j < graph[i].size(); ++j)
+            {
+                graph[i][j] *= num;
+            }
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? stoul(argv[1]) : DEFAULT_VERTICES;
+    double matrixBytes = double(n) * double(n) * sizeof(int);
+    Matrix a = randomMatrix(n, 1);
+    Matrix b = randomMatrix(n, 2);
+    Matrix c = randomMatrix(n, 3);
+    Graph g1;
+    Graph g2;
+    Graph g3;
+    g1.loadGraph(a);
+    g2.loadGraph(b);
+    g3.loadGraph(c);
+    Graph result;
+    Matrix nestedResult;
+
+    printf("%zu x %zu int matrices, GB/s of matrix traffic\n\n", n, n);
+    printf("%-14s %10s %10s %9s\n", "operator", "Graph", "nested", "speedup");
+
+    report("a + b", 3 * matrixBytes,
+           secondsPerCall([&]()
+                          { result = g1 + g2; }),
+           secondsPerCall([&]()
+                          { nestedResult = nestedAdd(a, b); }));
+    report("a - b", 3 * matrixBytes,
+           secondsPerCall([&]()
+                          { result = g1 - g2; }),
+           secondsPerCall([&]()
+                          { nestedResult = nestedSubtract(a, b); }));
+    report("a + b - c + a", 5 * matrixBytes,
+           secondsPerCall([&]()
+                          { result = g1 + g2 - g3 + g1; }),
+           secondsPerCall([&]()
+                          { Matrix sum = nestedAdd(a, b);
+                            Matrix difference = nestedSubtract(sum, c);
+                            nestedResult = nestedAdd(difference, a); }));
+    report("a += 3", 2 * matrixBytes,
+           secondsPerCall([&]()
+                          { g1 += 3; }),
+           secondsPerCall([&]()
+                          { nestedAddScalar(a, 3); }));
+    report("a -= 3", 2 * matrixBytes,
+           secondsPerCall([&]()
+                          { g1 -= 3; }),
+           secondsPerCall([&]()
+                          { nestedAddScalar(a, -3); }));
+    report("++a", 2 * matrixBytes,
+           secondsPerCall([&]()
+                          { ++g1; }),
+           secondsPerCall([&]()
+                          { nestedAddScalar(a, 1); }));
+    report("--a", 2 * matrixBytes,
+           secondsPerCall([&]()
+                          { --g1; }),
+           secondsPerCall([&]()
+                          { nestedAddScalar(a, -1); }));
+    report("a * -1", 2 * matrixBytes,
+           secondsPerCall([&]()
+                          { g1 *= -1; }),
+           secondsPerCall([&]()
+                          { nestedScale(a, -1); }));
+    return 0;
+}
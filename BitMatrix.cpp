@@ -0,0 +1,57 @@
+#include "BitMatrix.hpp"
+#include "Kernels.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using ariel::BitMatrix;
+
+// Blocking of the boolean product: a ROW_BLOCK x COLUMN_WORDS block of the result stays in L1
+// while the matching DEPTH_BLOCK x COLUMN_WORDS block of the right matrix stays in L2
+static constexpr size_t ROW_BLOCK = 64;
+static constexpr size_t DEPTH_BLOCK = 1024;
+static constexpr size_t COLUMN_WORDS = 64;
+
+// Function to multiply two boolean matrices 64 columns per word: row i of the product is the OR of
+// the rows k of other for every bit k set in row i, so a set bit costs a run of word ORs and a clear
+// bit nothing. The product is computed block by block, and the row blocks are split between threads.
+BitMatrix BitMatrix::operator*(const BitMatrix &other) const
+{
+    if (length != other.length)
+    {
+        throw runtime_error("Only bit matrices of the same size can be multiplied");
+    }
+    BitMatrix product(length, words.getResource());
+    uint64_t *out = product.words.data();
+    const uint64_t *right = other.words.data();
+    ariel::parallelFor(0, (length + ROW_BLOCK - 1) / ROW_BLOCK, [&](size_t firstBlock, size_t lastBlock)
+                       {
+                           for (size_t firstRow = firstBlock * ROW_BLOCK; firstRow < min(length, lastBlock * ROW_BLOCK); firstRow += ROW_BLOCK)
+                           {
+                               size_t lastRow = min(length, firstRow + ROW_BLOCK);
+                               for (size_t firstDepth = 0; firstDepth < length; firstDepth += DEPTH_BLOCK)
+                               {
+                                   size_t firstWord = firstDepth / WORD_BITS;
+                                   size_t lastWord = min(stride, (firstDepth + DEPTH_BLOCK) / WORD_BITS);
+                                   for (size_t firstColumn = 0; firstColumn < stride; firstColumn += COLUMN_WORDS)
+                                   {
+                                       size_t width = min(COLUMN_WORDS, stride - firstColumn);
+                                       for (size_t i = firstRow; i < lastRow; ++i)
+                                       {
+                                           const uint64_t *bits = row(i);
+                                           uint64_t *target = out + i * stride + firstColumn;
+                                           for (size_t w = firstWord; w < lastWord; ++w)
+                                           {
+                                               for (uint64_t word = bits[w]; word != 0; word &= word - 1)
+                                               {
+                                                   size_t k = w * WORD_BITS + size_t(__builtin_ctzll(word));
+                                                   ariel::simd::orInto(target, right + k * stride + firstColumn, width);
+                                               }
+                                           }
+                                       }
+                                   }
+                               }
+                           } });
+    return product;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include <cstdint>
+
+namespace ariel
+{
+    /// @brief A square boolean matrix packed 64 columns per word, row-major.
+    /// Row i is words [i * wordsPerRow(), (i + 1) * wordsPerRow()), column j is bit (j % 64) of word j / 64.
+    /// Bits past the last column are always zero.
+    class BitMatrix
+    {
+    public:
+        static constexpr std::size_t WORD_BITS = 64;
+
+        BitMatrix() = default;
+
+        explicit BitMatrix(std::size_t size, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : length(size), stride((size + WORD_BITS - 1) / WORD_BITS), words(size * stride, 0, resource)
+        {
+        }
+
+        std::size_t size() const { return length; }
+        std::size_t wordsPerRow() const { return stride; }
+
+        std::uint64_t *row(std::size_t i) { return words.data() + i * stride; }
+        const std::uint64_t *row(std::size_t i) const { return words.data() + i * stride; }
+
+        bool test(std::size_t i, std::size_t j) const
+        {
+            return ((row(i)[j / WORD_BITS] >> (j % WORD_BITS)) & 1U) != 0;
+        }
+
+        void set(std::size_t i, std::size_t j)
+        {
+            row(i)[j / WORD_BITS] |= std::uint64_t(1) << (j % WORD_BITS);
+        }
+
+        /// @brief The boolean matrix product: bit (i, j) of the result is set iff bit (i, k) of this
+        /// matrix and bit (k, j) of other are both set for some k. Allocated from this matrix's resource.
+        BitMatrix operator*(const BitMatrix &other) const;
+
+    private:
+        std::size_t length = 0;
+        std::size_t stride = 0;
+        Buffer<std::uint64_t> words;
+    };
+} // namespace ariel
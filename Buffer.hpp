@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+namespace ariel
+{
+    /// @brief A fixed-size, contiguous and cache-line aligned array.
+    /// Used as the backing store of the graph so that a whole matrix is one allocation
+    /// that can be streamed linearly. A buffer can also adopt memory allocated elsewhere,
+    /// which it then releases through the deleter it was given. Memory is allocated from a
+    /// std::pmr::memory_resource (the default resource unless one is given).
+    ///
+    /// Copies are copy-on-write: copying a buffer only shares its elements, and the first
+    /// non-const access (data(), begin(), end() or operator[]) of a buffer whose elements
+    /// are shared gives it a private copy, allocated from the same resource. Const access
+    /// never copies, so a shared buffer can be read from several threads at once.
+    template <typename T>
+    class Buffer
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Buffer only holds plain values");
+
+    public:
+        static constexpr std::size_t ALIGNMENT = 64;
+        using Deleter = std::function<void(T *)>;
+
+        Buffer() = default;
+
+        // Takes ownership of count elements at data without copying them. An empty deleter
+        // leaves the memory to the caller, who must then keep it alive as long as the buffer.
+        Buffer(T *data, std::size_t count, Deleter deleter)
+            : block(data, [deleter = std::move(deleter)](T *pointer)
+                    {
+                        if (deleter)
+                        {
+                            deleter(pointer);
+                        } }),
+              length(count)
+        {
+        }
+
+        explicit Buffer(std::size_t count, const T &value = T(),
+                        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : block(allocate(count, resource)), length(count), resource(resource)
+        {
+            std::fill(block.get(), block.get() + length, value);
+        }
+
+        Buffer(const Buffer &other) = default;
+
+        // Makes a private copy of other's elements in memory from resource
+        Buffer(const Buffer &other, std::pmr::memory_resource *resource)
+            : block(allocate(other.length, resource)), length(other.length), resource(resource)
+        {
+            std::copy(other.begin(), other.end(), block.get());
+        }
+
+        Buffer(Buffer &&other) noexcept
+            : block(std::move(other.block)), length(std::exchange(other.length, 0)), resource(other.resource)
+        {
+        }
+
+        Buffer &operator=(Buffer other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+        // Drops trailing elements without reallocating (count must not exceed size())
+        void shrink(std::size_t count)
+        {
+            length = std::min(length, count);
+        }
+
+        // Gives the buffer its own copy of the elements if another buffer shares them
+        void detach()
+        {
+            if (shared())
+            {
+                Buffer copy(*this, resource);
+                swap(copy);
+            }
+        }
+
+        // True if another buffer shares the elements
+        bool shared() const { return block.use_count() > 1; }
+
+        void swap(Buffer &other) noexcept
+        {
+            std::swap(block, other.block);
+            std::swap(length, other.length);
+            std::swap(resource, other.resource);
+        }
+
+        T *data()
+        {
+            detach();
+            return block.get();
+        }
+        const T *data() const { return block.get(); }
+        std::size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+
+        T *begin() { return data(); }
+        T *end() { return data() + length; }
+        const T *begin() const { return block.get(); }
+        const T *end() const { return block.get() + length; }
+
+        T &operator[](std::size_t index) { return data()[index]; }
+        const T &operator[](std::size_t index) const { return block.get()[index]; }
+
+        std::pmr::memory_resource *getResource() const { return resource; }
+
+    private:
+        std::shared_ptr<T> block; // the elements, released with the last buffer sharing them
+        std::size_t length = 0;
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource(); // where copies are allocated
+
+        static std::shared_ptr<T> allocate(std::size_t count, std::pmr::memory_resource *resource)
+        {
+            if (count == 0)
+            {
+                return nullptr;
+            }
+            T *pointer = static_cast<T *>(resource->allocate(count * sizeof(T), ALIGNMENT));
+            return std::shared_ptr<T>(pointer, [count, resource](T *elements)
+                                      { resource->deallocate(elements, count * sizeof(T), ALIGNMENT); },
+                                      std::pmr::polymorphic_allocator<T>(resource));
+        }
+    };
+} // namespace ariel
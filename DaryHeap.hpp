@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace ariel
+{
+    /// @brief A min-heap of vertices keyed by distance, with ARITY children per node and decrease-key.
+    /// Wider nodes make the heap shallower, so a push or a decrease-key, the common operations of Dijkstra's
+    /// algorithm, moves an entry up fewer levels, and the children a pop compares share a cache line or two.
+    template <typename Key, std::size_t ARITY = 4>
+    class DaryHeap
+    {
+    private:
+        using Entry = std::pair<Key, std::size_t>; // (key, vertex)
+        static constexpr std::size_t ABSENT = std::numeric_limits<std::size_t>::max();
+
+        std::pmr::vector<Entry> entries;        // in heap order
+        std::pmr::vector<std::size_t> position; // index of each vertex in entries, or ABSENT
+
+        void place(std::size_t index, Entry entry)
+        {
+            entries[index] = entry;
+            position[entry.second] = index;
+        }
+
+        // Moves the hole at index up until entry fits there
+        void siftUp(std::size_t index, Entry entry)
+        {
+            while (index > 0)
+            {
+                std::size_t parent = (index - 1) / ARITY;
+                if (entries[parent].first <= entry.first)
+                {
+                    break;
+                }
+                place(index, entries[parent]);
+                index = parent;
+            }
+            place(index, entry);
+        }
+
+        // Moves the hole at index down until entry fits there
+        void siftDown(std::size_t index, Entry entry)
+        {
+            std::size_t size = entries.size();
+            for (std::size_t first = index * ARITY + 1; first < size; first = index * ARITY + 1)
+            {
+                std::size_t best = first;
+                for (std::size_t child = first + 1; child < std::min(first + ARITY, size); ++child)
+                {
+                    if (entries[child].first < entries[best].first)
+                    {
+                        best = child;
+                    }
+                }
+                if (entry.first <= entries[best].first)
+                {
+                    break;
+                }
+                place(index, entries[best]);
+                index = best;
+            }
+            place(index, entry);
+        }
+
+    public:
+        explicit DaryHeap(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : entries(resource), position(resource)
+        {
+        }
+
+        /// @brief Empties the heap, for vertices 0 to vertices - 1.
+        void reset(std::size_t vertices)
+        {
+            entries.clear();
+            position.assign(vertices, ABSENT);
+        }
+
+        bool empty() const { return entries.empty(); }
+
+        /// @brief The smallest key in the heap, which must not be empty.
+        Key topKey() const { return entries.front().first; }
+
+        /// @brief Inserts vertex with key, or lowers its key to key if it is in the heap with a larger one.
+        void push(std::size_t vertex, Key key)
+        {
+            std::size_t index = position[vertex];
+            if (index == ABSENT)
+            {
+                entries.emplace_back();
+                siftUp(entries.size() - 1, Entry(key, vertex));
+            }
+            else if (key < entries[index].first)
+            {
+                siftUp(index, Entry(key, vertex));
+            }
+        }
+
+        /// @brief Removes the vertex with the smallest key and returns it with its key.
+        Entry pop()
+        {
+            Entry top = entries.front();
+            Entry last = entries.back();
+            entries.pop_back();
+            if (!entries.empty())
+            {
+                siftDown(0, last);
+            }
+            position[top.second] = ABSENT;
+            return top;
+        }
+    };
+} // namespace ariel
@@ -86,7 +86,7 @@ int main()
     cout << "g4 = g3 * 9\n"
          << endl;
     g4 = g3 * 9;
-    cout << g3 << endl;
+    cout << g4 << endl;
 
     cout << "g4 = g1 * g2\n"
          << endl;
@@ -1,222 +1,806 @@
 #include "Graph.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 using namespace std;
-using ariel::Graph;
+using ariel::BasicGraph;
+using ariel::BitMatrix;
+using ariel::Edge;
+using ariel::GraphDifference;
+using ariel::GraphScaled;
+using ariel::GraphSum;
+using ariel::GraphTerm;
+using ariel::parallelFor;
+using ariel::Representation;
+using ariel::RowView;
+using ariel::WeightRange;
+
+// Constructs a dense graph with the given number of vertices and no edges
+template <typename W>
+BasicGraph<W>::BasicGraph(size_t vertices, pmr::memory_resource *resource)
+    : vertices(vertices), cells(vertices * vertices, 0, resource), outDegrees(vertices, 0, resource),
+      inDegrees(vertices, 0, resource), resource(resource)
+{
+}
+
+// Constructs an empty graph whose storage will be allocated from resource
+template <typename W>
+BasicGraph<W>::BasicGraph(pmr::memory_resource *resource) : resource(resource)
+{
+}
+
+// Constructs a copy of other that shares nothing with it, allocated from resource
+template <typename W>
+BasicGraph<W>::BasicGraph(const BasicGraph &other, pmr::memory_resource *resource)
+    : vertices(other.vertices), representation(other.representation), cells(other.cells, resource),
+      offsets(other.offsets, resource), columns(other.columns, resource), weights(other.weights, resource),
+      edgeCount(other.edgeCount), outDegrees(other.outDegrees, resource), inDegrees(other.inDegrees, resource),
+      resource(resource)
+{
+}
+
+// Constructs a copy of other that shares its arrays and the caches it has built so far
+template <typename W>
+BasicGraph<W>::BasicGraph(const BasicGraph &other)
+    : vertices(other.vertices), representation(other.representation), cells(other.cells), offsets(other.offsets),
+      columns(other.columns), weights(other.weights), edgeCount(other.edgeCount), outDegrees(other.outDegrees),
+      inDegrees(other.inDegrees), resource(other.resource)
+{
+    copyCaches(other);
+}
+
+// Constructs a graph that takes over the arrays and caches of other, which is left empty
+template <typename W>
+BasicGraph<W>::BasicGraph(BasicGraph &&other) noexcept
+    : vertices(other.vertices), representation(other.representation), cells(std::move(other.cells)),
+      offsets(std::move(other.offsets)), columns(std::move(other.columns)), weights(std::move(other.weights)),
+      edgeCount(other.edgeCount), outDegrees(std::move(other.outDegrees)), inDegrees(std::move(other.inDegrees)),
+      resource(other.resource)
+{
+    moveCaches(other);
+}
+
+// Operator to make this graph share the arrays and caches of other
+template <typename W>
+BasicGraph<W> &BasicGraph<W>::operator=(const BasicGraph &other)
+{
+    if (this != &other)
+    {
+        vertices = other.vertices;
+        representation = other.representation;
+        cells = other.cells;
+        offsets = other.offsets;
+        columns = other.columns;
+        weights = other.weights;
+        edgeCount = other.edgeCount;
+        outDegrees = other.outDegrees;
+        inDegrees = other.inDegrees;
+        resource = other.resource;
+        copyCaches(other);
+    }
+    return *this;
+}
+
+// Operator to make this graph take over the arrays and caches of other
+template <typename W>
+BasicGraph<W> &BasicGraph<W>::operator=(BasicGraph &&other) noexcept
+{
+    if (this != &other)
+    {
+        vertices = other.vertices;
+        representation = other.representation;
+        cells = std::move(other.cells);
+        offsets = std::move(other.offsets);
+        columns = std::move(other.columns);
+        weights = std::move(other.weights);
+        edgeCount = other.edgeCount;
+        outDegrees = std::move(other.outDegrees);
+        inDegrees = std::move(other.inDegrees);
+        resource = other.resource;
+        moveCaches(other);
+    }
+    return *this;
+}
+
+// Function to share the caches of other. Const readers of other may be publishing a cache at the same
+// time (see adjacencyBits()), so each one is read with atomic_load rather than copied.
+template <typename W>
+void BasicGraph<W>::copyCaches(const BasicGraph &other)
+{
+    atomic_store(&adjacencyCache, atomic_load(&other.adjacencyCache));
+    atomic_store(&weightRangeCache, atomic_load(&other.weightRangeCache));
+    atomic_store(&transposeCache, atomic_load(&other.transposeCache));
+}
+
+// Function to take over the caches of other, leaving it none
+template <typename W>
+void BasicGraph<W>::moveCaches(BasicGraph &other)
+{
+    atomic_store(&adjacencyCache, atomic_exchange(&other.adjacencyCache, shared_ptr<const BitMatrix>()));
+    atomic_store(&weightRangeCache, atomic_exchange(&other.weightRangeCache, shared_ptr<const WeightRange<W>>()));
+    atomic_store(&transposeCache, atomic_exchange(&other.transposeCache, shared_ptr<const BasicGraph>()));
+}
 
 // Function to check if the adjacency matrix is square
-bool Graph::isSquare(const vector<vector<int>> &adjacencyMatrix)
+template <typename W>
+bool BasicGraph<W>::isSquare(const vector<vector<W>> &adjacencyMatrix)
 {
     size_t rows = adjacencyMatrix.size();
     if (rows == 0)
     {
         return false;
     }
-    size_t cols = adjacencyMatrix[0].size();
-    return rows == cols;
+    for (const auto &row : adjacencyMatrix)
+    {
+        if (row.size() != rows)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to decide whether a graph of the given size is worth storing as CSR
+template <typename W>
+bool BasicGraph<W>::prefersSparse(size_t edges, size_t vertices)
+{
+    double cellCount = static_cast<double>(vertices) * static_cast<double>(vertices);
+    return static_cast<double>(edges) < SPARSE_DENSITY * cellCount;
 }
 
 // Function to count the number of vertices in the graph
-size_t Graph::countVertices() const
+template <typename W>
+size_t BasicGraph<W>::countVertices() const
 {
-    return graph.size();
+    return vertices;
 }
 
 // Function to count the number of edges in the graph
-size_t Graph::countEdges() const
+template <typename W>
+size_t BasicGraph<W>::countEdges() const
 {
-    size_t edges = 0;
-    for (const auto &row : graph)
+    return edgeCount;
+}
+
+// Function to zero the edge and degree counters before a pass that recounts them
+template <typename W>
+void BasicGraph<W>::resetCounts()
+{
+    edgeCount = 0;
+    outDegrees = allocate<size_t>(vertices, 0);
+    inDegrees = allocate<size_t>(vertices, 0);
+}
+
+// Function to convert a CSR graph into a dense matrix
+template <typename W>
+void BasicGraph<W>::toDense()
+{
+    if (representation == Representation::Dense)
     {
-        for (int value : row)
+        return;
+    }
+    Buffer<W> dense = allocate<W>(vertices * vertices, 0);
+    const BasicGraph &sparse = *this; // read-only, so shared CSR arrays are not copied first
+    W *out = dense.data();
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        for (size_t e = sparse.offsets[i]; e < sparse.offsets[i + 1]; ++e)
+        {
+            out[i * vertices + sparse.columns[e]] = sparse.weights[e];
+        }
+    }
+    cells = std::move(dense);
+    offsets = Buffer<size_t>();
+    columns = Buffer<size_t>();
+    weights = Buffer<W>();
+    representation = Representation::Dense;
+}
+
+// Function to convert a dense matrix into CSR
+template <typename W>
+void BasicGraph<W>::toSparse()
+{
+    if (representation == Representation::Sparse)
+    {
+        return;
+    }
+    Buffer<size_t> rowStarts = allocate<size_t>(vertices + 1, 0);
+    Buffer<size_t> edgeColumns = allocate<size_t>(edgeCount);
+    Buffer<W> edgeWeights = allocate<W>(edgeCount);
+    const W *cell = as_const(cells).data(); // read-only, so a shared matrix is not copied first
+    size_t e = 0;
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        rowStarts[i] = e;
+        for (size_t j = 0; j < vertices; ++j, ++cell)
+        {
+            if (*cell != 0)
+            {
+                edgeColumns[e] = j;
+                edgeWeights[e] = *cell;
+                ++e;
+            }
+        }
+    }
+    rowStarts[vertices] = e;
+    offsets = std::move(rowStarts);
+    columns = std::move(edgeColumns);
+    weights = std::move(edgeWeights);
+    cells = Buffer<W>();
+    representation = Representation::Sparse;
+}
+
+// Function to switch to whichever representation suits the current density
+template <typename W>
+void BasicGraph<W>::chooseRepresentation()
+{
+    if (prefersSparse(countEdges(), vertices))
+    {
+        toSparse();
+    }
+    else
+    {
+        toDense();
+    }
+}
+
+// Function to drop everything derived from the edge weights after a mutation
+template <typename W>
+void BasicGraph<W>::invalidateCaches()
+{
+    atomic_store(&adjacencyCache, shared_ptr<const BitMatrix>());
+    atomic_store(&weightRangeCache, shared_ptr<const WeightRange<W>>());
+    atomic_store(&transposeCache, shared_ptr<const BasicGraph>());
+}
+
+// Function to get the dense matrix, expanding a CSR graph into scratch if needed
+template <typename W>
+const W *BasicGraph<W>::denseCells(Buffer<W> &scratch) const
+{
+    if (representation == Representation::Dense)
+    {
+        return cells.data();
+    }
+    BasicGraph dense(*this);
+    dense.toDense();
+    scratch = std::move(dense.cells);
+    return scratch.data();
+}
+
+// Function to combine two CSR graphs entry by entry, touching only their edges
+template <typename W>
+template <typename Operation>
+BasicGraph<W> BasicGraph<W>::mergeSparse(const BasicGraph &other, Operation operation) const
+{
+    BasicGraph result(resource);
+    result.vertices = vertices;
+    result.representation = Representation::Sparse;
+    result.offsets = allocate<size_t>(vertices + 1, 0);
+    result.columns = allocate<size_t>(columns.size() + other.columns.size());
+    result.weights = allocate<W>(columns.size() + other.columns.size());
+    result.resetCounts();
+    size_t e = 0;
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        result.offsets[i] = e;
+        size_t a = offsets[i];
+        size_t b = other.offsets[i];
+        while (a < offsets[i + 1] || b < other.offsets[i + 1])
         {
+            size_t col;
+            W value;
+            if (b == other.offsets[i + 1] || (a < offsets[i + 1] && columns[a] < other.columns[b]))
+            {
+                col = columns[a];
+                value = operation(weights[a++], W(0));
+            }
+            else if (a == offsets[i + 1] || other.columns[b] < columns[a])
+            {
+                col = other.columns[b];
+                value = operation(W(0), other.weights[b++]);
+            }
+            else
+            {
+                col = columns[a];
+                value = operation(weights[a++], other.weights[b++]);
+            }
             if (value != 0)
             {
-                edges++;
+                result.columns[e] = col;
+                result.weights[e] = value;
+                result.countEdge(i, col);
+                ++e;
             }
         }
     }
+    result.offsets[vertices] = e;
+    result.columns.shrink(e);
+    result.weights.shrink(e);
+    result.chooseRepresentation();
+    return result;
+}
+
+// Function to count the non-zero entries of an adjacency matrix
+template <typename W>
+size_t BasicGraph<W>::countNonZero(const vector<vector<W>> &adjacencyMatrix)
+{
+    size_t edges = 0;
+    for (const auto &row : adjacencyMatrix)
+    {
+        edges += size_t(count_if(row.begin(), row.end(), [](W value)
+                                 { return value != 0; }));
+    }
     return edges;
 }
 
-// Function to load the graph with the given adjacency matrix
-void Graph::loadGraph(const vector<vector<int>> &adjacencyMatrix)
+// Function to build the graph from the rows of an adjacency matrix in the given representation.
+// When the rows are not const each one is freed as soon as it is copied, so loading a matrix
+// that is being moved in never holds two full copies of it.
+template <typename W>
+template <typename Rows>
+void BasicGraph<W>::loadRows(Rows &adjacencyMatrix, Representation storage)
 {
     if (!isSquare(adjacencyMatrix))
     {
         throw runtime_error("Invalid adjacency matrix: not square");
     }
-    graph = adjacencyMatrix;
+    size_t n = adjacencyMatrix.size();
+    BasicGraph loaded(resource);
+    loaded.vertices = n;
+    loaded.representation = storage;
+    loaded.resetCounts();
+    if (storage == Representation::Dense)
+    {
+        loaded.cells = allocate<W>(n * n);
+        W *out = loaded.cells.data();
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                W value = adjacencyMatrix[i][j];
+                *out++ = value;
+                if (value != 0)
+                {
+                    loaded.countEdge(i, j);
+                }
+            }
+            if constexpr (!is_const<Rows>::value)
+            {
+                vector<W>().swap(adjacencyMatrix[i]);
+            }
+        }
+    }
+    else
+    {
+        size_t edges = countNonZero(adjacencyMatrix);
+        loaded.offsets = allocate<size_t>(n + 1, 0);
+        loaded.columns = allocate<size_t>(edges);
+        loaded.weights = allocate<W>(edges);
+        size_t e = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            loaded.offsets[i] = e;
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (adjacencyMatrix[i][j] != 0)
+                {
+                    loaded.columns[e] = j;
+                    loaded.weights[e] = adjacencyMatrix[i][j];
+                    loaded.countEdge(i, j);
+                    ++e;
+                }
+            }
+            if constexpr (!is_const<Rows>::value)
+            {
+                vector<W>().swap(adjacencyMatrix[i]);
+            }
+        }
+        loaded.offsets[n] = e;
+    }
+    *this = std::move(loaded);
+}
+
+// Function to load the graph with the given adjacency matrix, choosing the representation by density
+template <typename W>
+void BasicGraph<W>::loadGraph(const vector<vector<W>> &adjacencyMatrix)
+{
+    loadGraph(adjacencyMatrix, prefersSparse(countNonZero(adjacencyMatrix), adjacencyMatrix.size()) ? Representation::Sparse : Representation::Dense);
+}
+
+// Function to load the graph with the given adjacency matrix into the given representation
+template <typename W>
+void BasicGraph<W>::loadGraph(const vector<vector<W>> &adjacencyMatrix, Representation storage)
+{
+    loadRows(adjacencyMatrix, storage);
+}
+
+// Function to load the graph from a matrix the caller no longer needs, freeing its rows while loading
+template <typename W>
+void BasicGraph<W>::loadGraph(vector<vector<W>> &&adjacencyMatrix)
+{
+    loadGraph(std::move(adjacencyMatrix), prefersSparse(countNonZero(adjacencyMatrix), adjacencyMatrix.size()) ? Representation::Sparse : Representation::Dense);
+}
+
+// Function to load the graph from a matrix the caller no longer needs into the given representation
+template <typename W>
+void BasicGraph<W>::loadGraph(vector<vector<W>> &&adjacencyMatrix, Representation storage)
+{
+    vector<vector<W>> consumed(std::move(adjacencyMatrix));
+    loadRows(consumed, storage);
+}
+
+// Function to take ownership of a dense row-major n x n matrix without copying it.
+// The graph keeps the dense representation and releases the matrix through deleter.
+template <typename W>
+void BasicGraph<W>::adoptGraph(W *matrix, size_t vertices, typename Buffer<W>::Deleter deleter)
+{
+    Buffer<W> adopted(matrix, vertices * vertices, std::move(deleter));
+    if (vertices == 0 || matrix == nullptr)
+    {
+        throw runtime_error("Invalid adjacency matrix: empty");
+    }
+    BasicGraph loaded(resource);
+    loaded.vertices = vertices;
+    loaded.representation = Representation::Dense;
+    loaded.cells = std::move(adopted);
+    loaded.resetCounts();
+    for (size_t i = 0, k = 0; i < vertices; ++i)
+    {
+        for (size_t j = 0; j < vertices; ++j, ++k)
+        {
+            if (matrix[k] != 0)
+            {
+                loaded.countEdge(i, j);
+            }
+        }
+    }
+    *this = std::move(loaded);
+}
+
+// Function to take over the storage of a flat row-major n x n vector without copying it
+template <typename W>
+void BasicGraph<W>::adoptGraph(vector<W> &&matrix, size_t vertices)
+{
+    if (matrix.size() != vertices * vertices)
+    {
+        throw runtime_error("Invalid adjacency matrix: not square");
+    }
+    auto *owner = new vector<W>(std::move(matrix));
+    adoptGraph(owner->data(), vertices, [owner](W *)
+               { delete owner; });
 }
 
 // Function to print the graph
-void Graph::printGraph() const
+template <typename W>
+void BasicGraph<W>::printGraph() const
 {
     cout << "Graph with " << countVertices() << " vertices and " << countEdges() << " edges:\n"
          << endl;
-    for (const auto &row : graph)
+    vector<W> line(vertices);
+    for (size_t i = 0; i < vertices; ++i)
     {
-        for (int value : row)
+        fill(line.begin(), line.end(), 0);
+        for (Edge<W> edge : neighbors(i))
+        {
+            line[edge.to] = edge.weight;
+        }
+        for (W value : line)
         {
-            cout << value << ' ';
+            cout << +value << ' '; // unary plus prints 8-bit weights as numbers
         }
         cout << endl;
     }
     cout << endl;
 }
 
-// Function to get the adjacency matrix of the graph
-const vector<vector<int>> &Graph::getGraph() const
+// Function to get the representation the graph is currently stored in
+template <typename W>
+Representation BasicGraph<W>::getRepresentation() const
 {
-    return graph;
+    return representation;
 }
 
-// Function to get the number of vertices in the graph
-size_t Graph::getVertices() const
+// Function to get a view of the outgoing edge weights of a vertex (dense graphs only)
+template <typename W>
+RowView<W> BasicGraph<W>::row(size_t vertex) const
 {
-    return countVertices();
+    if (representation != Representation::Dense)
+    {
+        throw logic_error("Row views are only available for dense graphs");
+    }
+    return RowView(cells.data() + vertex * vertices, vertices);
 }
 
-// Function to get the number of edges in the graph
-size_t Graph::getEdges() const
+// Function to get the weight of the edge between two vertices (0 if there is none)
+template <typename W>
+W BasicGraph<W>::getWeight(size_t from, size_t to) const
 {
-    return countEdges();
+    if (representation == Representation::Dense)
+    {
+        return at(from, to);
+    }
+    const size_t *first = columns.data() + offsets[from];
+    const size_t *last = columns.data() + offsets[from + 1];
+    const size_t *found = lower_bound(first, last, to);
+    return found != last && *found == to ? weights[size_t(found - columns.data())] : 0;
 }
 
-// Operator to add another graph to the current graph
-Graph Graph::operator+(const Graph &other)
+// Function to get the bit-packed adjacency matrix (bit j of row i is set iff there is an edge i -> j).
+// Built on first use and shared until the graph is modified; safe to call from several threads.
+template <typename W>
+shared_ptr<const BitMatrix> BasicGraph<W>::adjacencyBits() const
 {
-    Graph g;
-    vector<vector<int>> adjMat(graph.size(), vector<int>(graph.size(), 0));
-    const auto &otherGraph = other.getGraph();
-    if (graph.size() != otherGraph.size() || graph.empty())
+    shared_ptr<const BitMatrix> cached = atomic_load(&adjacencyCache);
+    if (cached)
     {
-        throw runtime_error("Graphs of different sizes cannot be added");
+        return cached;
     }
-    for (size_t i = 0; i < graph.size(); ++i)
+    cached = allocate_shared<BitMatrix>(pmr::polymorphic_allocator<BitMatrix>(resource), unownedView().toBitMatrix(resource));
+    atomic_store(&adjacencyCache, cached);
+    return cached;
+}
+
+// Function to get the smallest and largest edge weights, e.g. to check that there are no negative ones.
+// Found on first use and kept until the graph is modified; safe to call from several threads.
+template <typename W>
+WeightRange<W> BasicGraph<W>::weightRange() const
+{
+    shared_ptr<const WeightRange<W>> cached = atomic_load(&weightRangeCache);
+    if (!cached)
     {
-        for (size_t j = 0; j < graph[i].size(); ++j)
-        {
-            adjMat[i][j] = graph[i][j] + otherGraph[i][j];
-        }
+        cached = allocate_shared<WeightRange<W>>(pmr::polymorphic_allocator<WeightRange<W>>(resource), unownedView().findWeightRange());
+        atomic_store(&weightRangeCache, cached);
     }
-    g.loadGraph(adjMat);
-    return g;
+    return *cached;
 }
 
-// Operator to subtract another graph from the current graph
-Graph Graph::operator-(const Graph &other)
+// Function to get the graph with every edge reversed, e.g. to search backwards from a vertex. Row i of the transpose
+// holds the edges into i, built as CSR from the in-degrees in one pass over the edges and then stored in whichever
+// representation suits its density. Built on first use and kept until the graph is modified; safe to call from
+// several threads.
+template <typename W>
+shared_ptr<const BasicGraph<W>> BasicGraph<W>::transposed() const
 {
-    Graph g;
-    vector<vector<int>> adjMat(graph.size(), vector<int>(graph.size(), 0));
-    const auto &otherGraph = other.getGraph();
-    if (graph.size() != otherGraph.size() || graph.empty())
+    shared_ptr<const BasicGraph> cached = atomic_load(&transposeCache);
+    if (cached)
+    {
+        return cached;
+    }
+    BasicGraph reversed(resource);
+    reversed.vertices = vertices;
+    reversed.representation = Representation::Sparse;
+    reversed.offsets = allocate<size_t>(vertices + 1, 0);
+    reversed.columns = allocate<size_t>(edgeCount);
+    reversed.weights = allocate<W>(edgeCount);
+    reversed.edgeCount = edgeCount;
+    reversed.outDegrees = inDegrees;
+    reversed.inDegrees = outDegrees;
+    size_t *next = reversed.offsets.data();
+    for (size_t i = 0; i < vertices; ++i)
     {
-        throw runtime_error("Graphs of different sizes cannot be subtracted");
+        next[i + 1] = next[i] + inDegrees[i];
     }
-    for (size_t i = 0; i < graph.size(); ++i)
+    // next[j] is where the next edge into j goes; rows are visited in order, so each row comes out sorted
+    pmr::vector<size_t> fill(next, next + vertices, resource);
+    GraphView<W> edges = unownedView();
+    for (size_t i = 0; i < vertices; ++i)
     {
-        for (size_t j = 0; j < graph[i].size(); ++j)
+        for (Edge<W> edge : edges.neighbors(i))
         {
-            adjMat[i][j] = graph[i][j] -= otherGraph[i][j];
+            size_t e = fill[edge.to]++;
+            reversed.columns[e] = i;
+            reversed.weights[e] = edge.weight;
         }
     }
-    g.loadGraph(adjMat);
-    return g;
+    reversed.chooseRepresentation();
+    cached = allocate_shared<BasicGraph>(pmr::polymorphic_allocator<BasicGraph>(resource), std::move(reversed));
+    atomic_store(&transposeCache, cached);
+    return cached;
+}
+
+// Function to get the number of vertices in the graph
+template <typename W>
+size_t BasicGraph<W>::getVertices() const
+{
+    return countVertices();
+}
+
+// Function to get the number of edges in the graph
+template <typename W>
+size_t BasicGraph<W>::getEdges() const
+{
+    return countEdges();
+}
+
+// Function to get the number of edges leaving a vertex
+template <typename W>
+size_t BasicGraph<W>::getOutDegree(size_t vertex) const
+{
+    return outDegrees[vertex];
+}
+
+// Function to get the number of edges entering a vertex
+template <typename W>
+size_t BasicGraph<W>::getInDegree(size_t vertex) const
+{
+    return inDegrees[vertex];
+}
+
+// Function to get the memory resource the graph's storage is allocated from
+template <typename W>
+pmr::memory_resource *BasicGraph<W>::getResource() const
+{
+    return resource;
+}
+
+// Operator to add another graph to the current graph. Returns an expression that is evaluated,
+// together with any further terms, when it is assigned to a graph.
+template <typename W>
+ariel::GraphSum<W> BasicGraph<W>::operator+(const BasicGraph &other) const
+{
+    return GraphSum<W>(GraphTerm<W>(*this), GraphTerm<W>(other), "Graphs of different sizes cannot be added");
+}
+
+// Operator to subtract another graph from the current graph. Lazy like operator+: the difference
+// is computed when the returned expression is assigned to a graph, and neither operand changes.
+template <typename W>
+ariel::GraphDifference<W> BasicGraph<W>::operator-(const BasicGraph &other) const
+{
+    return GraphDifference<W>(GraphTerm<W>(*this), GraphTerm<W>(other), "Graphs of different sizes cannot be subtracted");
+}
+
+// Function to combine another graph into the current graph in place, entry by entry: Operation is
+// AddWeights or SubtractWeights (see GraphExpr.hpp)
+template <typename W>
+template <typename Operation>
+void BasicGraph<W>::mergeInPlace(const BasicGraph &other, const char *sizeError)
+{
+    if (vertices != other.vertices || vertices == 0)
+    {
+        throw runtime_error(sizeError);
+    }
+    if (representation == Representation::Sparse && other.representation == Representation::Sparse)
+    {
+        *this = mergeSparse(other, Operation());
+        return;
+    }
+    toDense();
+    Buffer<W> scratch;
+    const W *right = other.denseCells(scratch);
+    W *left = cells.data(); // copies the matrix first if another graph shares it
+    if (right == left)
+    {
+        // g += g, g -= g: the kernels need operands that do not overlap
+        scratch = Buffer<W>(cells, resource);
+        right = scratch.data();
+    }
+    resetCounts();
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        Operation::apply(left + i * vertices, right + i * vertices, left + i * vertices, vertices);
+        countRow(i, left + i * vertices);
+    }
+    invalidateCaches();
+    chooseRepresentation();
+}
+
+// Operator to add another graph to the current graph in place
+template <typename W>
+void BasicGraph<W>::operator+=(const BasicGraph &other)
+{
+    mergeInPlace<ariel::AddWeights>(other, "Graphs of different sizes cannot be added");
+}
+
+// Operator to subtract another graph from the current graph in place
+template <typename W>
+void BasicGraph<W>::operator-=(const BasicGraph &other)
+{
+    mergeInPlace<ariel::SubtractWeights>(other, "Graphs of different sizes cannot be subtracted");
 }
 
 // Operator to perform in-place addition of a scalar value to all elements in the graph
-void Graph::operator+=(int num)
+template <typename W>
+void BasicGraph<W>::operator+=(W num)
 {
-    for (size_t i = 0; i < graph.size(); ++i)
+    if (num == 0)
     {
-        for (size_t j = 0; j < graph[i].size(); ++j)
-        {
-            graph[i][j] += num;
-        }
+        return;
+    }
+    toDense();
+    W *cell = cells.data(); // copies the matrix first if another graph shares it
+    size_t *columnCounts = inDegrees.data();
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        adjustRow(i, simd::addScalarCounted(cell + i * vertices, num, vertices, columnCounts));
     }
+    invalidateCaches();
+    chooseRepresentation();
 }
 
 // Operator to perform in-place subtraction of a scalar value from all elements in the graph
-void Graph::operator-=(int num)
+template <typename W>
+void BasicGraph<W>::operator-=(W num)
 {
-    for (size_t i = 0; i < graph.size(); ++i)
+    if (num == 0)
     {
-        for (size_t j = 0; j < graph[i].size(); ++j)
-        {
-            graph[i][j] -= num;
-        }
+        return;
     }
+    toDense();
+    W *cell = cells.data(); // copies the matrix first if another graph shares it
+    size_t *columnCounts = inDegrees.data();
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        adjustRow(i, simd::subtractScalarCounted(cell + i * vertices, num, vertices, columnCounts));
+    }
+    invalidateCaches();
+    chooseRepresentation();
 }
 
 // Operator to increment all elements in the graph by 1
-void Graph::operator++()
+template <typename W>
+void BasicGraph<W>::operator++()
 {
-    for (size_t i = 0; i < graph.size(); ++i)
-    {
-        for (size_t j = 0; j < graph[i].size(); ++j)
-        {
-            graph[i][j] += 1;
-        }
-    }
+    *this += W(1);
 }
 
 // Postfix version
-void Graph::operator++(int)
+template <typename W>
+void BasicGraph<W>::operator++(int)
 {
     ++*this;
 }
 
 // Operator to decrement all elements in the graph by 1
-void Graph::operator--()
+template <typename W>
+void BasicGraph<W>::operator--()
 {
-    for (size_t i = 0; i < graph.size(); ++i)
-    {
-        for (size_t j = 0; j < graph[i].size(); ++j)
-        {
-            graph[i][j] -= 1;
-        }
-    }
+    *this -= W(1);
 }
 
 // Postfix version
-void Graph::operator--(int)
+template <typename W>
+void BasicGraph<W>::operator--(int)
 {
     --*this;
 }
 
 // Unary plus operator
-void Graph::operator+()
+template <typename W>
+void BasicGraph<W>::operator+()
 {
     // Unary plus does not change the sign of the expression
 }
 
 // Unary minus operator
-void Graph::operator-()
+template <typename W>
+void BasicGraph<W>::operator-()
 {
-    *this *(-1);
+    *this *= W(-1);
 }
 
 // Checks if other graph is a proper subset of this graph
-bool Graph::operator>(const Graph &other) const
+template <typename W>
+bool BasicGraph<W>::operator>(const BasicGraph &other) const
 {
-    vector<vector<int>> g = other.getGraph();
-
-    if (graph.size() < g.size() || graph[0].size() < g[0].size())
+    if (vertices < other.vertices)
     {
         return false;
     }
 
     bool flag = false;
-    for (size_t i = 0; i < g.size(); i++)
+    for (size_t i = 0; i < other.vertices; i++)
     {
-        for (size_t u = 0; u < g.size(); u++)
+        for (size_t u = 0; u < other.vertices; u++)
         {
-            if (g[i][u] != 0 && g[i][u] != graph[i][u])
+            W value = other.getWeight(i, u);
+            if (value != 0 && value != getWeight(i, u))
             {
                 flag = false;
                 break;
             }
-            if (g[i][u] != 0 && graph[i][u] != 0)
+            if (value != 0 && getWeight(i, u) != 0)
             {
                 flag = true;
             }
@@ -239,24 +823,42 @@ bool Graph::operator>(const Graph &other) const
 }
 
 // Checks if this graph is a proper subset of other graph
-bool Graph::operator<(const Graph &other) const
+template <typename W>
+bool BasicGraph<W>::operator<(const BasicGraph &other) const
 {
     return other > *this;
 }
 
 // Checks if both graphs are equal in value and size
-bool Graph::operator==(const Graph &other) const
+template <typename W>
+bool BasicGraph<W>::operator==(const BasicGraph &other) const
 {
-    vector<vector<int>> g = other.getGraph();
-    if (graph.size() != g.size() || graph[0].size() != g[0].size())
+    if (vertices != other.vertices)
     {
         return false;
     }
-    for (size_t i = 0; i < g.size(); i++)
+    if (representation == Representation::Dense && other.representation == Representation::Dense)
+    {
+        return equal(cells.begin(), cells.end(), other.cells.begin());
+    }
+    if (representation == Representation::Sparse && other.representation == Representation::Sparse)
+    {
+        return equal(offsets.begin(), offsets.end(), other.offsets.begin()) &&
+               equal(columns.begin(), columns.end(), other.columns.begin(), other.columns.end()) &&
+               equal(weights.begin(), weights.end(), other.weights.begin(), other.weights.end());
+    }
+    // Mixed representations: same edge count and every sparse edge present in the dense one
+    const BasicGraph &sparse = representation == Representation::Sparse ? *this : other;
+    const BasicGraph &dense = representation == Representation::Sparse ? other : *this;
+    if (sparse.countEdges() != dense.countEdges())
     {
-        for (size_t u = 0; u < g.size(); u++)
+        return false;
+    }
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        for (Edge<W> edge : sparse.neighbors(i))
         {
-            if (graph[i][u] != g[i][u])
+            if (dense.at(i, edge.to) != edge.weight)
             {
                 return false;
             }
@@ -266,66 +868,684 @@ bool Graph::operator==(const Graph &other) const
 }
 
 // Checks if both Graphs are not equal in value or size
-bool Graph::operator!=(const Graph &other) const
+template <typename W>
+bool BasicGraph<W>::operator!=(const BasicGraph &other) const
 {
     return !(*this == other);
 }
 
 // Checks if other graph is a subset of this graph
-bool Graph::operator>=(const Graph &other) const
+template <typename W>
+bool BasicGraph<W>::operator>=(const BasicGraph &other) const
 {
     return *this > other || *this == other;
 }
 
 // Checks if this graph is a subset of other graph
-bool Graph::operator<=(const Graph &other) const
+template <typename W>
+bool BasicGraph<W>::operator<=(const BasicGraph &other) const
 {
     return *this < other || *this == other;
 }
 
 // Operator to perform scalar multiplication of the graph by a given value
-Graph Graph::operator*(int num)
+template <typename W>
+ariel::GraphScaled<W, ariel::GraphTerm<W>> BasicGraph<W>::operator*(W num) const
+{
+    return GraphScaled<W, GraphTerm<W>>(GraphTerm<W>(*this), num);
+}
+
+// Operator to multiply all elements in the graph by a scalar value in place
+template <typename W>
+void BasicGraph<W>::operator*=(W num)
+{
+    if (num == 0)
+    {
+        *this = BasicGraph(vertices, resource);
+        chooseRepresentation();
+        return;
+    }
+    // Multiplying by a non-zero value keeps every edge, so the counters and representation stay as they are
+    Buffer<W> &values = representation == Representation::Dense ? cells : weights;
+    simd::scale(values.data(), num, values.size()); // copies the values first if another graph shares them
+    invalidateCaches();
+}
+
+// Blocking of the matrix product: ROW_BLOCK x DEPTH_BLOCK of the packed left matrix stays in L2,
+// a DEPTH_BLOCK x TILE_COLUMNS panel of the packed right matrix in L1
+static constexpr size_t ROW_BLOCK = 64;
+static constexpr size_t DEPTH_BLOCK = 256;
+static constexpr size_t COLUMN_BLOCK = 256;
+
+namespace
 {
-    Graph g;
-    vector<vector<int>> adjMat(graph.size(), vector<int>(graph.size(), 0));
-    for (size_t i = 0; i < graph.size(); ++i)
+    // Multiplies the dense n x n matrices left and right into out over the semiring S, converting
+    // the entries read with lift and the entries written with lower. For each COLUMN_BLOCK columns
+    // of the result, the matching columns of right are packed into TILE_COLUMNS wide panels shared
+    // by every thread. The rows of the result are split between the threads ROW_BLOCK at a time; a
+    // thread packs its rows of left DEPTH_BLOCK columns at a time into TILE_ROWS high panels, and
+    // simd::multiplyTile adds their products into a block of sums that is only lowered once the
+    // whole shared dimension has been summed.
+    template <typename S, typename In, typename Out, typename Lift, typename Lower>
+    void multiplyBlocked(size_t n, const In *left, const In *right, Out *out, Lift lift, Lower lower,
+                         pmr::memory_resource *resource)
+    {
+        using ariel::simd::TILE_COLUMNS;
+        using ariel::simd::TILE_ROWS;
+        using Value = typename S::Value;
+        const size_t stride = COLUMN_BLOCK;
+        ariel::Buffer<Value> packedRight(n * COLUMN_BLOCK, S::zero(), resource);
+        for (size_t firstColumn = 0; firstColumn < n; firstColumn += COLUMN_BLOCK)
+        {
+            size_t width = min(COLUMN_BLOCK, n - firstColumn);
+            size_t panels = (width + TILE_COLUMNS - 1) / TILE_COLUMNS;
+            Value *packed = packedRight.data();
+            // Panel p holds columns p * TILE_COLUMNS.. of the block, row k of right at packed[(p * n + k) * TILE_COLUMNS]
+            parallelFor(0, n, [&](size_t begin, size_t end)
+                        {
+                            for (size_t k = begin; k < end; ++k)
+                            {
+                                const In *row = right + k * n + firstColumn;
+                                for (size_t j = 0; j < panels * TILE_COLUMNS; ++j)
+                                {
+                                    packed[((j / TILE_COLUMNS) * n + k) * TILE_COLUMNS + j % TILE_COLUMNS] = j < width ? lift(row[j]) : S::zero();
+                                }
+                            } },
+                        ROW_BLOCK);
+
+            parallelFor(0, (n + ROW_BLOCK - 1) / ROW_BLOCK, [&](size_t firstBlock, size_t lastBlock)
+                        {
+                            // The graph's resource is not shared between threads, so per-thread scratch comes from the heap
+                            ariel::Buffer<Value> packedLeft(ROW_BLOCK * DEPTH_BLOCK, S::zero(), pmr::new_delete_resource());
+                            ariel::Buffer<Value> sumsBuffer(ROW_BLOCK * stride, S::zero(), pmr::new_delete_resource());
+                            Value *a = packedLeft.data();
+                            Value *sums = sumsBuffer.data();
+                            for (size_t block = firstBlock; block < lastBlock; ++block)
+                            {
+                                size_t firstRow = block * ROW_BLOCK;
+                                size_t height = min(ROW_BLOCK, n - firstRow);
+                                size_t rowPanels = (height + TILE_ROWS - 1) / TILE_ROWS;
+                                fill(sums, sums + ROW_BLOCK * stride, S::zero());
+                                for (size_t firstDepth = 0; firstDepth < n; firstDepth += DEPTH_BLOCK)
+                                {
+                                    size_t depth = min(DEPTH_BLOCK, n - firstDepth);
+                                    for (size_t i = 0; i < rowPanels * TILE_ROWS; ++i)
+                                    {
+                                        Value *panel = a + (i / TILE_ROWS) * depth * TILE_ROWS + i % TILE_ROWS;
+                                        const In *row = left + (firstRow + i) * n + firstDepth;
+                                        for (size_t k = 0; k < depth; ++k)
+                                        {
+                                            panel[k * TILE_ROWS] = i < height ? lift(row[k]) : S::zero();
+                                        }
+                                    }
+                                    for (size_t p = 0; p < panels; ++p)
+                                    {
+                                        const Value *b = packed + (p * n + firstDepth) * TILE_COLUMNS;
+                                        for (size_t q = 0; q < rowPanels; ++q)
+                                        {
+                                            ariel::simd::multiplyTile(S(), a + q * depth * TILE_ROWS, b,
+                                                                      sums + q * TILE_ROWS * stride + p * TILE_COLUMNS, stride, depth);
+                                        }
+                                    }
+                                }
+                                for (size_t i = 0; i < height; ++i)
+                                {
+                                    for (size_t j = 0; j < width; ++j)
+                                    {
+                                        out[(firstRow + i) * n + firstColumn + j] = lower(sums[i * stride + j]);
+                                    }
+                                }
+                            } });
+        }
+    }
+
+    // (+, x) on 64-bit integers with every addition and multiplication checked, for the products whose
+    // sums might not fit: the kernels would otherwise overflow int64_t, which is undefined behavior
+    struct CheckedPlusTimes : ariel::PlusTimes<int64_t>
+    {
+        static int64_t add(int64_t a, int64_t b)
+        {
+            int64_t sum;
+            if (__builtin_add_overflow(a, b, &sum))
+            {
+                throw overflow_error("The product of the graphs overflows 64-bit integers");
+            }
+            return sum;
+        }
+        static int64_t multiply(int64_t a, int64_t b)
+        {
+            int64_t product;
+            if (__builtin_mul_overflow(a, b, &product))
+            {
+                throw overflow_error("The product of the graphs overflows 64-bit integers");
+            }
+            return product;
+        }
+    };
+
+    // The largest magnitude of lift(values[i]) for i < count
+    template <typename T, typename Lift>
+    uint64_t largestMagnitude(const T *values, size_t count, Lift lift)
+    {
+        uint64_t largest = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int64_t value = lift(values[i]);
+            largest = max(largest, value < 0 ? uint64_t(0) - uint64_t(value) : uint64_t(value));
+        }
+        return largest;
+    }
+
+    // True if every sum of a plus-times product of n x n matrices, whose entries are at most left and
+    // right in magnitude, fits int64_t: none exceeds n * left * right
+    bool plusTimesFits(size_t n, uint64_t left, uint64_t right)
+    {
+        uint64_t bound;
+        return !__builtin_mul_overflow(left, right, &bound) && !__builtin_mul_overflow(bound, uint64_t(n), &bound) &&
+               bound <= uint64_t(numeric_limits<int64_t>::max());
+    }
+
+    // multiplyBlocked, except that an integral plus-times product whose sums might overflow is computed
+    // row by row with CheckedPlusTimes instead, throwing overflow_error if one does
+    template <typename S, typename In, typename Out, typename Lift, typename Lower>
+    void multiplyDense(size_t n, const In *left, const In *right, Out *out, Lift lift, Lower lower,
+                       pmr::memory_resource *resource)
     {
-        for (size_t j = 0; j < graph[i].size(); ++j)
+        if constexpr (is_same<S, ariel::PlusTimes<int64_t>>::value)
         {
-            adjMat[i][j] = graph[i][j] *= num;
+            if (!plusTimesFits(n, largestMagnitude(left, n * n, lift), largestMagnitude(right, n * n, lift)))
+            {
+                parallelFor(0, n, [&](size_t begin, size_t end)
+                            {
+                                vector<int64_t> sums(n);
+                                for (size_t i = begin; i < end; ++i)
+                                {
+                                    fill(sums.begin(), sums.end(), 0);
+                                    for (size_t k = 0; k < n; ++k)
+                                    {
+                                        int64_t weight = lift(left[i * n + k]);
+                                        for (size_t j = 0; weight != 0 && j < n; ++j)
+                                        {
+                                            sums[j] = CheckedPlusTimes::add(sums[j], CheckedPlusTimes::multiply(weight, lift(right[k * n + j])));
+                                        }
+                                    }
+                                    for (size_t j = 0; j < n; ++j)
+                                    {
+                                        out[i * n + j] = lower(sums[j]);
+                                    }
+                                } });
+                return;
+            }
         }
+        multiplyBlocked<S>(n, left, right, out, lift, lower, resource);
     }
-    g.loadGraph(adjMat);
-    return g;
+} // namespace
+
+// Rows of a sparse product handed to a thread at a time
+static constexpr size_t SPARSE_ROW_CHUNK = 256;
+
+namespace
+{
+    // Sums the entries of one row of a sparse product over the semiring S. A row whose entries are bounded by a small
+    // fraction of the columns is summed in an open-addressing hash table small enough to stay in
+    // cache; a row that may touch many columns is summed in a dense array indexed by column.
+    template <typename S>
+    class RowAccumulator
+    {
+        using A = typename S::Value;
+
+    public:
+        explicit RowAccumulator(size_t columns) : columnCount(columns) {}
+
+        // Starts a row with at most bound entries
+        void start(size_t bound)
+        {
+            hashed = bound * HASH_RATIO < columnCount;
+            if (hashed)
+            {
+                size_t capacity = 16;
+                while (capacity < 2 * bound)
+                {
+                    capacity *= 2;
+                }
+                if (keys.size() < capacity)
+                {
+                    keys.assign(capacity, EMPTY);
+                    sums.assign(capacity, S::zero());
+                }
+                mask = capacity - 1;
+            }
+            else if (dense.empty())
+            {
+                dense.assign(columnCount, S::zero());
+                marked.assign(columnCount, 0);
+            }
+        }
+
+        void add(size_t column, A value)
+        {
+            if (!hashed)
+            {
+                if (!marked[column])
+                {
+                    marked[column] = 1;
+                    touched.push_back(column);
+                }
+                dense[column] = S::add(dense[column], value);
+                return;
+            }
+            size_t slot = (column * 0x9E3779B97F4A7C15ULL >> 20) & mask;
+            while (keys[slot] != column)
+            {
+                if (keys[slot] == EMPTY)
+                {
+                    keys[slot] = column;
+                    touched.push_back(slot);
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+            sums[slot] = S::add(sums[slot], value);
+        }
+
+        // Calls emit(column, sum) for every entry of the row in ascending column order, and clears it
+        template <typename Emit>
+        void finish(Emit emit)
+        {
+            entries.clear();
+            for (size_t index : touched)
+            {
+                if (hashed)
+                {
+                    entries.emplace_back(keys[index], sums[index]);
+                    keys[index] = EMPTY;
+                    sums[index] = S::zero();
+                }
+                else
+                {
+                    entries.emplace_back(index, dense[index]);
+                    dense[index] = S::zero();
+                    marked[index] = 0;
+                }
+            }
+            touched.clear();
+            sort(entries.begin(), entries.end(), [](const pair<size_t, A> &a, const pair<size_t, A> &b)
+                 { return a.first < b.first; });
+            for (const pair<size_t, A> &entry : entries)
+            {
+                emit(entry.first, entry.second);
+            }
+        }
+
+    private:
+        static constexpr size_t HASH_RATIO = 32;
+        static constexpr size_t EMPTY = numeric_limits<size_t>::max();
+        size_t columnCount;
+        bool hashed = false;
+        size_t mask = 0;
+        vector<size_t> keys; // hashed: the column in each slot, or EMPTY
+        vector<A> sums;      // hashed: the sum in each slot
+        vector<A> dense;     // dense: the sum of each column
+        vector<char> marked; // dense: whether a column is in touched
+        vector<size_t> touched; // the slots (hashed) or columns (dense) in use
+        vector<pair<size_t, A>> entries;
+    };
+} // namespace
+
+// Function to multiply two CSR graphs row by row (Gustavson's algorithm). Row i of the product is
+// the sum of the rows of other selected by the edges of row i, multiplied by their weights, so the work
+// is proportional to the multiplications actually made rather than to n^3. Each thread gathers its
+// rows in a RowAccumulator; rows are split into chunks whose edges are then copied into the CSR
+// arrays of the result.
+template <typename W>
+template <typename S>
+BasicGraph<W> BasicGraph<W>::multiplySparse(const BasicGraph &other) const
+{
+    using Value = typename S::Value;
+    struct Chunk
+    {
+        vector<size_t> columns;
+        vector<W> weights;
+    };
+    vector<Chunk> chunks((vertices + SPARSE_ROW_CHUNK - 1) / SPARSE_ROW_CHUNK);
+    Buffer<size_t> rowStarts = allocate<size_t>(vertices + 1, 0);
+    size_t *rowLength = rowStarts.data() + 1; // the length of row i, until the prefix sum below
+    parallelFor(0, chunks.size(), [&](size_t firstChunk, size_t lastChunk)
+                {
+                    RowAccumulator<S> row(vertices);
+                    for (size_t c = firstChunk; c < lastChunk; ++c)
+                    {
+                        Chunk &chunk = chunks[c];
+                        for (size_t i = c * SPARSE_ROW_CHUNK; i < min(vertices, (c + 1) * SPARSE_ROW_CHUNK); ++i)
+                        {
+                            size_t bound = 0;
+                            for (size_t e = offsets[i]; e < offsets[i + 1]; ++e)
+                            {
+                                bound += other.offsets[columns[e] + 1] - other.offsets[columns[e]];
+                            }
+                            row.start(bound);
+                            for (size_t e = offsets[i]; e < offsets[i + 1]; ++e)
+                            {
+                                Value weight = S::lift(weights[e]);
+                                size_t k = columns[e];
+                                for (size_t f = other.offsets[k]; f < other.offsets[k + 1]; ++f)
+                                {
+                                    row.add(other.columns[f], S::multiply(weight, S::lift(other.weights[f])));
+                                }
+                            }
+                            size_t length = 0;
+                            row.finish([&](size_t j, Value sum)
+                                       {
+                                           W value = S::template lower<W>(sum);
+                                           if (value != 0)
+                                           {
+                                               chunk.columns.push_back(j);
+                                               chunk.weights.push_back(value);
+                                               ++length;
+                                           } });
+                            rowLength[i] = length;
+                        }
+                    } });
+
+    BasicGraph result(resource);
+    result.vertices = vertices;
+    result.representation = Representation::Sparse;
+    result.resetCounts();
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        result.outDegrees[i] = rowLength[i];
+        rowLength[i] += rowStarts[i];
+    }
+    result.edgeCount = rowStarts[vertices];
+    result.columns = allocate<size_t>(result.edgeCount);
+    result.weights = allocate<W>(result.edgeCount);
+    size_t *edgeColumns = result.columns.data();
+    W *edgeWeights = result.weights.data();
+    parallelFor(0, chunks.size(), [&](size_t firstChunk, size_t lastChunk)
+                {
+                    for (size_t c = firstChunk; c < lastChunk; ++c)
+                    {
+                        size_t start = rowStarts[c * SPARSE_ROW_CHUNK];
+                        copy(chunks[c].columns.begin(), chunks[c].columns.end(), edgeColumns + start);
+                        copy(chunks[c].weights.begin(), chunks[c].weights.end(), edgeWeights + start);
+                    } });
+    size_t *inDegree = result.inDegrees.data();
+    for (size_t e = 0; e < result.edgeCount; ++e)
+    {
+        ++inDegree[edgeColumns[e]];
+    }
+    result.offsets = std::move(rowStarts);
+    result.chooseRepresentation();
+    return result;
 }
 
-// Operator to multiply two graphs
-Graph Graph::operator*(const Graph &other) const
+// Function to multiply two graphs over a semiring
+template <typename W>
+template <template <typename> class Semiring>
+BasicGraph<W> BasicGraph<W>::multiply(const BasicGraph &other) const
 {
-    const auto &otherGraph = other.getGraph();
-    if (graph[0].size() != otherGraph.size() || graph.empty())
+    using S = Semiring<Accumulator>;
+    if (vertices != other.vertices || vertices == 0)
     {
         throw runtime_error("Only valid graph sizes 'n X m * m X l' can be multiplied");
     }
-    Graph result;
-    vector<vector<int>> resultMatrix(graph.size(), vector<int>(graph.size(), 0));
-    for (size_t i = 0; i < graph.size(); ++i)
+    if (representation == Representation::Sparse && other.representation == Representation::Sparse)
+    {
+        if constexpr (is_same<S, ariel::PlusTimes<int64_t>>::value)
+        {
+            auto lift = [](W weight)
+            { return S::lift(weight); };
+            if (!plusTimesFits(vertices, largestMagnitude(weights.data(), edgeCount, lift),
+                               largestMagnitude(other.weights.data(), other.edgeCount, lift)))
+            {
+                return multiplySparse<CheckedPlusTimes>(other);
+            }
+        }
+        return multiplySparse<S>(other);
+    }
+    BasicGraph result(vertices, resource);
+    W *product = result.cells.data();
+    if constexpr (is_same<S, ariel::OrAnd<Accumulator>>::value)
     {
-        for (size_t j = 0; j < graph.size(); ++j)
+        // Reachability only needs the bit-packed adjacency matrices, 64 columns per word
+        BitMatrix bits = *adjacencyBits() * *other.adjacencyBits();
+        for (size_t i = 0; i < vertices; ++i)
         {
-            for (size_t k = 0; k < graph.size(); ++k)
+            for (size_t j = 0; j < vertices; ++j)
             {
-                resultMatrix[i][j] += graph[i][k] * otherGraph[k][j];
+                product[i * vertices + j] = bits.test(i, j) ? W(1) : W(0);
             }
+            result.countRow(i, product + i * vertices);
         }
+        result.chooseRepresentation();
+        return result;
+    }
+    Buffer<W> leftScratch;
+    Buffer<W> rightScratch;
+    const W *left = denseCells(leftScratch);
+    const W *right = other.denseCells(rightScratch);
+    multiplyDense<S>(
+        vertices, left, right, product, [](W weight)
+        { return S::lift(weight); },
+        [](typename S::Value value)
+        { return S::template lower<W>(value); },
+        resource);
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        result.countRow(i, product + i * vertices);
     }
-    result.loadGraph(resultMatrix);
+    result.chooseRepresentation();
     return result;
 }
 
+// Operator to multiply two graphs
+template <typename W>
+BasicGraph<W> BasicGraph<W>::operator*(const BasicGraph &other) const
+{
+    return multiply<ariel::PlusTimes>(other);
+}
+
+namespace
+{
+    // Raises the n x n matrix base to the k-th power (k >= 1) by repeated squaring, in about
+    // 2 log2(k) products instead of k - 1. multiply(a, b, out) computes one product into out; the
+    // three matrices involved are reused for every product.
+    template <typename T, typename Multiply>
+    ariel::Buffer<T> raise(ariel::Buffer<T> base, size_t k, Multiply multiply)
+    {
+        ariel::Buffer<T> power; // empty while it is still the identity
+        ariel::Buffer<T> product(base.size(), T(), base.getResource());
+        while (k > 0)
+        {
+            if (k & 1)
+            {
+                if (power.empty())
+                {
+                    power = ariel::Buffer<T>(base, base.getResource());
+                }
+                else
+                {
+                    multiply(as_const(power).data(), as_const(base).data(), product.data());
+                    power.swap(product);
+                }
+            }
+            k >>= 1;
+            if (k > 0)
+            {
+                multiply(as_const(base).data(), as_const(base).data(), product.data());
+                base.swap(product);
+            }
+        }
+        return power;
+    }
+
+    // Multiplies the n x n matrices a and b, whose entries are in [0, modulus) with modulus < 2^31,
+    // into out modulo modulus. Every entry is split into 16-bit halves, x = high * 2^16 + low, so
+    // that the products of halves summed by the plus-times kernel stay below n * 2^32 and cannot
+    // overflow; the four partial products are reduced and recombined one at a time.
+    void multiplyModulo(size_t n, const int64_t *a, const int64_t *b, int64_t *out, int64_t modulus,
+                        pmr::memory_resource *resource)
+    {
+        using S = ariel::PlusTimes<int64_t>;
+        size_t count = n * n;
+        ariel::Buffer<int64_t> halves(4 * count, 0, resource);
+        ariel::Buffer<int64_t> partialBuffer(count, 0, resource);
+        int64_t *aHigh = halves.data();
+        int64_t *aLow = aHigh + count;
+        int64_t *bHigh = aLow + count;
+        int64_t *bLow = bHigh + count;
+        int64_t *partial = partialBuffer.data();
+        for (size_t i = 0; i < count; ++i)
+        {
+            aHigh[i] = a[i] >> 16;
+            aLow[i] = a[i] & 0xFFFF;
+            bHigh[i] = b[i] >> 16;
+            bLow[i] = b[i] & 0xFFFF;
+        }
+        fill(out, out + count, 0);
+        auto unchanged = [](int64_t value)
+        { return value; };
+        auto accumulate = [&](const int64_t *left, const int64_t *right, int64_t scale)
+        {
+            multiplyBlocked<S>(n, left, right, partial, unchanged, unchanged, resource);
+            for (size_t i = 0; i < count; ++i)
+            {
+                out[i] = (out[i] + partial[i] % modulus * scale) % modulus;
+            }
+        };
+        accumulate(aHigh, bHigh, (int64_t(1) << 32) % modulus);
+        accumulate(aHigh, bLow, (int64_t(1) << 16) % modulus);
+        accumulate(aLow, bHigh, (int64_t(1) << 16) % modulus);
+        accumulate(aLow, bLow, 1 % modulus);
+    }
+} // namespace
+
+// Function to build a graph of this size from a dense row-major matrix of values, converting each with lower
+template <typename W>
+template <typename T, typename Lower>
+BasicGraph<W> BasicGraph<W>::fromValues(const T *values, Lower lower) const
+{
+    BasicGraph result(vertices, resource);
+    W *cell = result.cells.data();
+    for (size_t i = 0; i < vertices * vertices; ++i)
+    {
+        cell[i] = lower(values[i]);
+    }
+    for (size_t i = 0; i < vertices; ++i)
+    {
+        result.countRow(i, cell + i * vertices);
+    }
+    result.chooseRepresentation();
+    return result;
+}
+
+// Function to raise the graph to the k-th power over a semiring
+template <typename W>
+template <template <typename> class Semiring>
+BasicGraph<W> BasicGraph<W>::pow(size_t k) const
+{
+    using S = Semiring<Accumulator>;
+    using Value = typename S::Value;
+    if (vertices == 0)
+    {
+        throw runtime_error("Only a non-empty graph can be raised to a power");
+    }
+    Buffer<W> scratch;
+    const W *cell = denseCells(scratch);
+    // The powers are computed on semiring values and only lowered to weights at the end, so
+    // intermediate powers neither overflow W nor lose the semiring's one() on the diagonal
+    Buffer<Value> base = allocate<Value>(vertices * vertices);
+    Value *entry = base.data();
+    for (size_t i = 0; i < vertices * vertices; ++i)
+    {
+        entry[i] = k == 0 ? S::zero() : S::lift(cell[i]);
+    }
+    if (k == 0 || S::idempotent)
+    {
+        for (size_t i = 0; i < vertices; ++i)
+        {
+            entry[i * vertices + i] = S::add(entry[i * vertices + i], S::one());
+        }
+    }
+    if (k > 0)
+    {
+        auto unchanged = [](Value value)
+        { return value; };
+        base = raise(std::move(base), k, [&](const Value *a, const Value *b, Value *out)
+                     { multiplyDense<S>(vertices, a, b, out, unchanged, unchanged, resource); });
+    }
+    return fromValues(as_const(base).data(), [](Value value)
+                      { return S::template lower<W>(value); });
+}
+
+// Function to raise the graph to the k-th power modulo modulus
+template <typename W>
+BasicGraph<W> BasicGraph<W>::pow(size_t k, Accumulator modulus) const
+{
+    if constexpr (is_floating_point<W>::value)
+    {
+        throw runtime_error("Only graphs with integral weights can be raised to a power modulo a number");
+    }
+    else
+    {
+        if (vertices == 0)
+        {
+            throw runtime_error("Only a non-empty graph can be raised to a power");
+        }
+        if (modulus < 1 || modulus > numeric_limits<int32_t>::max())
+        {
+            throw runtime_error("The modulus must be between 1 and 2^31 - 1");
+        }
+        Buffer<W> scratch;
+        const W *cell = denseCells(scratch);
+        Buffer<int64_t> base = allocate<int64_t>(vertices * vertices);
+        int64_t *entry = base.data();
+        for (size_t i = 0; i < vertices * vertices; ++i)
+        {
+            entry[i] = k == 0 ? 0 : (int64_t(cell[i]) % modulus + modulus) % modulus;
+        }
+        if (k == 0)
+        {
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                entry[i * vertices + i] = 1 % modulus;
+            }
+        }
+        else
+        {
+            base = raise(std::move(base), k, [&](const int64_t *a, const int64_t *b, int64_t *out)
+                         { multiplyModulo(vertices, a, b, out, modulus, resource); });
+        }
+        return fromValues(as_const(base).data(), [](int64_t value)
+                          { return ariel::narrowWeight<W>(value); });
+    }
+}
+
 // Output operator <<
-ostream &ariel::operator<<(ostream &os, const Graph &g)
+template <typename W>
+ostream &ariel::operator<<(ostream &os, const BasicGraph<W> &g)
 {
     g.printGraph();
     return os;
 }
+
+// The supported semirings
+#define ARIEL_INSTANTIATE_SEMIRING(W, Semiring)                                                                 \
+    template ariel::BasicGraph<W> ariel::BasicGraph<W>::multiply<ariel::Semiring>(const BasicGraph<W> &) const; \
+    template ariel::BasicGraph<W> ariel::BasicGraph<W>::pow<ariel::Semiring>(size_t) const;
+
+// The supported weight types
+#define ARIEL_INSTANTIATE_GRAPH(W)                                             \
+    template class ariel::BasicGraph<W>;                                       \
+    ARIEL_INSTANTIATE_SEMIRING(W, PlusTimes)                                   \
+    ARIEL_INSTANTIATE_SEMIRING(W, MinPlus)                                     \
+    ARIEL_INSTANTIATE_SEMIRING(W, OrAnd)                                       \
+    ARIEL_INSTANTIATE_SEMIRING(W, MaxMin)                                      \
+    template ostream &ariel::operator<< <W>(ostream &, const BasicGraph<W> &);
+
+ARIEL_INSTANTIATE_GRAPH(int8_t)
+ARIEL_INSTANTIATE_GRAPH(int16_t)
+ARIEL_INSTANTIATE_GRAPH(int32_t)
+ARIEL_INSTANTIATE_GRAPH(int64_t)
+ARIEL_INSTANTIATE_GRAPH(float)
+ARIEL_INSTANTIATE_GRAPH(double)
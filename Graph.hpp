@@ -1,5 +1,15 @@
 #pragma once
 
+#include "Buffer.hpp"
+#include "BitMatrix.hpp"
+#include "GraphExpr.hpp"
+#include "GraphView.hpp"
+#include "Kernels.hpp"
+#include "Semiring.hpp"
+#include "WeightTraits.hpp"
+#include <memory>
+#include <memory_resource>
+#include <string>
 #include <vector>
 #include <iostream>
 #include <stdexcept>
@@ -7,38 +17,312 @@
 using namespace std;
 namespace ariel
 {
-    class Graph
+    /// @brief A read-only view over one row of a dense adjacency matrix.
+    template <typename W>
+    class RowView
     {
     private:
-        vector<vector<int>> graph;
-        static bool isSquare(const vector<vector<int>> &adjacencyMatrix);
+        const W *first;
+        size_t count;
+
+    public:
+        RowView(const W *first, size_t count) : first(first), count(count) {}
+        const W *begin() const { return first; }
+        const W *end() const { return first + count; }
+        const W *data() const { return first; }
+        size_t size() const { return count; }
+        W operator[](size_t index) const { return first[index]; }
+    };
+
+    /// @brief Throughput of one run of a text loader.
+    struct LoadStats
+    {
+        size_t bytes = 0;   // size of the file
+        size_t rows = 0;    // entry lines parsed
+        double seconds = 0; // wall time, from opening the file to the finished graph
+
+        double rowsPerSecond() const { return seconds > 0 ? double(rows) / seconds : 0; }
+        double bytesPerSecond() const { return seconds > 0 ? double(bytes) / seconds : 0; }
+    };
+
+    /// @brief A directed graph with edge weights of type W (int8_t, int16_t, int32_t, int64_t, float or double).
+    /// A zero weight means there is no edge. All of a graph's storage, and that of the graphs its operators
+    /// return, comes from one std::pmr::memory_resource; copies share it.
+    /// Copies are O(1): a copy shares the matrix of the original, and whichever of them is modified
+    /// first (by an operator, or a loader) gets its own copy of the arrays it writes to.
+    template <typename W>
+    class BasicGraph
+    {
+    public:
+        using Weight = W;
+        using Accumulator = typename WeightTraits<W>::Accumulator;
+
+        // Graphs with fewer than this fraction of non-zero entries are stored as CSR
+        static constexpr double SPARSE_DENSITY = 0.1;
+
+    private:
+        size_t vertices = 0;
+        Representation representation = Representation::Dense;
+        Buffer<W> cells;        // dense: n x n adjacency matrix, stored row-major in one block
+        Buffer<size_t> offsets; // sparse: row i occupies [offsets[i], offsets[i + 1]) of columns/weights
+        Buffer<size_t> columns; // sparse: column index of each edge, ascending within a row
+        Buffer<W> weights;      // sparse: weight of each edge, never zero
+        size_t edgeCount = 0;      // number of non-zero entries, kept up to date by every mutation
+        Buffer<size_t> outDegrees; // non-zero entries per row
+        Buffer<size_t> inDegrees;  // non-zero entries per column
+        mutable shared_ptr<const BitMatrix> adjacencyCache; // built on first use, dropped on mutation
+        mutable shared_ptr<const WeightRange<W>> weightRangeCache; // likewise
+        mutable shared_ptr<const BasicGraph> transposeCache;       // likewise
+        pmr::memory_resource *resource = pmr::get_default_resource(); // where every buffer above is allocated
+        BasicGraph(size_t vertices, pmr::memory_resource *resource);
+        template <typename T>
+        Buffer<T> allocate(size_t count, T value = T()) const
+        {
+            return Buffer<T>(count, value, resource);
+        }
+        static bool isSquare(const vector<vector<W>> &adjacencyMatrix);
+        static size_t countNonZero(const vector<vector<W>> &adjacencyMatrix);
+        template <typename Rows>
+        void loadRows(Rows &adjacencyMatrix, Representation storage);
+        template <typename Chunks>
+        void loadEntries(size_t n, Chunks &chunks);
+        static bool prefersSparse(size_t edges, size_t vertices);
         size_t countVertices() const;
         size_t countEdges() const;
+        void resetCounts();
+        void countEdge(size_t from, size_t to)
+        {
+            ++edgeCount;
+            ++outDegrees[from];
+            ++inDegrees[to];
+        }
+        void countRow(size_t from, const W *row)
+        {
+            size_t edges = simd::countNonZero(row, vertices, inDegrees.data());
+            outDegrees[from] = edges;
+            edgeCount += edges;
+        }
+        // Applies a change in the number of non-zero entries of row from (the in-degrees are already updated)
+        void adjustRow(size_t from, ptrdiff_t change)
+        {
+            outDegrees[from] = size_t(ptrdiff_t(outDegrees[from]) + change);
+            edgeCount = size_t(ptrdiff_t(edgeCount) + change);
+        }
+        W &at(size_t row, size_t col) { return cells[row * vertices + col]; }
+        W at(size_t row, size_t col) const { return cells[row * vertices + col]; }
+        void toDense();
+        void toSparse();
+        void chooseRepresentation();
+        void invalidateCaches();
+        void copyCaches(const BasicGraph &other);
+        void moveCaches(BasicGraph &other);
+        const W *denseCells(Buffer<W> &scratch) const;
+        template <typename S>
+        BasicGraph multiplySparse(const BasicGraph &other) const;
+        template <typename T, typename Lower>
+        BasicGraph fromValues(const T *values, Lower lower) const;
+        GraphView<W> unownedView() const
+        {
+            return representation == Representation::Dense
+                       ? GraphView<W>(cells.data(), vertices)
+                       : GraphView<W>(offsets.data(), columns.data(), weights.data(), vertices);
+        }
+        template <typename Operation>
+        BasicGraph mergeSparse(const BasicGraph &other, Operation operation) const;
+        template <typename Operation>
+        void mergeInPlace(const BasicGraph &other, const char *sizeError);
+        template <typename>
+        friend class GraphTerm;
 
     public:
-        void loadGraph(const vector<vector<int>> &adjacencyMatrix);
+        BasicGraph() = default;
+        explicit BasicGraph(pmr::memory_resource *resource);
+        BasicGraph(const BasicGraph &other, pmr::memory_resource *resource);
+        template <typename E>
+        BasicGraph(const GraphExpr<W, E> &expression);
+        BasicGraph(const BasicGraph &other);
+        BasicGraph(BasicGraph &&other) noexcept;
+        BasicGraph &operator=(const BasicGraph &other);
+        BasicGraph &operator=(BasicGraph &&other) noexcept;
+        void loadGraph(const vector<vector<W>> &adjacencyMatrix);
+        void loadGraph(const vector<vector<W>> &adjacencyMatrix, Representation storage);
+        void loadGraph(vector<vector<W>> &&adjacencyMatrix);
+        void loadGraph(vector<vector<W>> &&adjacencyMatrix, Representation storage);
+        void adoptGraph(W *matrix, size_t vertices, typename Buffer<W>::Deleter deleter);
+        void adoptGraph(vector<W> &&matrix, size_t vertices);
+        void save(const string &path) const;                     // defined in GraphIO.cpp
+        void mapFile(const string &path, bool validate = false); // defined in GraphIO.cpp
+        LoadStats loadEdgeList(const string &path);     // defined in GraphIO.cpp
+        LoadStats loadMatrixMarket(const string &path); // defined in GraphIO.cpp
         void printGraph() const;
-        const vector<vector<int>> &getGraph() const;
+        Representation getRepresentation() const;
+        RowView<W> row(size_t vertex) const;
+        W getWeight(size_t from, size_t to) const;
+        shared_ptr<const BitMatrix> adjacencyBits() const;
+        WeightRange<W> weightRange() const;
+        shared_ptr<const BasicGraph> transposed() const;
         size_t getVertices() const;
         size_t getEdges() const;
-        Graph operator+(const Graph &other);
-        Graph operator-(const Graph &other);
-        void operator+=(int num);
-        void operator-=(int num);
+        size_t getOutDegree(size_t vertex) const;
+        size_t getInDegree(size_t vertex) const;
+        pmr::memory_resource *getResource() const;
+
+        /// @brief A non-owning view of the graph, valid until the graph is modified or destroyed.
+        GraphView<W> view() const
+        {
+            return GraphView<W>(unownedView(), this);
+        }
+
+        /// @brief The outgoing edges (non-zero entries) of a vertex in ascending order.
+        /// Costs O(n) per row when dense and O(degree) when sparse.
+        NeighborRange<W> neighbors(size_t vertex) const
+        {
+            return view().neighbors(vertex);
+        }
+
+        GraphSum<W> operator+(const BasicGraph &other) const;
+        GraphDifference<W> operator-(const BasicGraph &other) const;
+        void operator+=(const BasicGraph &other);
+        void operator-=(const BasicGraph &other);
+        void operator+=(W num);
+        void operator-=(W num);
         void operator++();
         void operator++(int);
         void operator--();
         void operator--(int);
         void operator+();
         void operator-();
-        bool operator>=(const Graph &other) const;
-        bool operator<=(const Graph &other) const;
-        bool operator==(const Graph &other) const;
-        bool operator!=(const Graph &other) const;
-        bool operator>(const Graph &other) const;
-        bool operator<(const Graph &other) const;
-        Graph operator*(int num);
-        Graph operator*(const Graph &other) const;
-        friend ostream &operator<<(ostream &os, const Graph &g);
+        bool operator>=(const BasicGraph &other) const;
+        bool operator<=(const BasicGraph &other) const;
+        bool operator==(const BasicGraph &other) const;
+        bool operator!=(const BasicGraph &other) const;
+        bool operator>(const BasicGraph &other) const;
+        bool operator<(const BasicGraph &other) const;
+        GraphScaled<W, GraphTerm<W>> operator*(W num) const;
+        void operator*=(W num);
+        BasicGraph operator*(const BasicGraph &other) const;
+        /// @brief The matrix product of this graph and other over Semiring (PlusTimes, MinPlus,
+        /// OrAnd or MaxMin, see Semiring.hpp), by the same blocked, parallel kernels as operator*,
+        /// which is multiply<PlusTimes>. Missing edges are the semiring's zero. An integral product
+        /// over PlusTimes throws overflow_error if one of its 64-bit sums overflows.
+        template <template <typename> class Semiring>
+        BasicGraph multiply(const BasicGraph &other) const;
+        /// @brief The k-th power of the adjacency matrix over Semiring, by repeated squaring
+        /// (O(n^3 log k)). The powers are kept in the semiring's value type (64-bit for integral
+        /// weights) and only converted back to W at the end, which throws if an entry does not fit.
+        /// An integral product over PlusTimes whose 64-bit sums might overflow is computed with
+        /// checked arithmetic instead, and throws overflow_error if one does. Over PlusTimes entry
+        /// (i, j) counts the weighted walks of exactly k edges from i to j (the identity for k = 0).
+        /// Over the idempotent semirings the diagonal is the semiring's one, so the power covers
+        /// walks of at most k edges: pow<MinPlus>(k) gives the shortest distances using at most k
+        /// edges, pow<OrAnd>(k) reachability within k steps.
+        template <template <typename> class Semiring = PlusTimes>
+        BasicGraph pow(size_t k) const;
+        /// @brief The k-th power over PlusTimes with every entry reduced modulo modulus (1 to
+        /// 2^31 - 1), e.g. walk counts modulo a prime. Only for integral weights.
+        BasicGraph pow(size_t k, Accumulator modulus) const;
     };
+
+    template <typename W>
+    ostream &operator<<(ostream &os, const BasicGraph<W> &g);
+
+    /// @brief The matrix product of a and b over Semiring, e.g. multiply<MinPlus>(a, b).
+    template <template <typename> class Semiring, typename W>
+    BasicGraph<W> multiply(const BasicGraph<W> &a, const BasicGraph<W> &b)
+    {
+        return a.template multiply<Semiring>(b);
+    }
+
+    /// @brief multiply<Semiring> with an elementwise expression as an operand, which is evaluated first.
+    template <template <typename> class Semiring, typename W, typename L>
+    BasicGraph<W> multiply(const GraphExpr<W, L> &a, const BasicGraph<W> &b)
+    {
+        return BasicGraph<W>(a).template multiply<Semiring>(b);
+    }
+    template <template <typename> class Semiring, typename W, typename R>
+    BasicGraph<W> multiply(const BasicGraph<W> &a, const GraphExpr<W, R> &b)
+    {
+        return a.template multiply<Semiring>(BasicGraph<W>(b));
+    }
+    template <template <typename> class Semiring, typename W, typename L, typename R>
+    BasicGraph<W> multiply(const GraphExpr<W, L> &a, const GraphExpr<W, R> &b)
+    {
+        return BasicGraph<W>(a).template multiply<Semiring>(BasicGraph<W>(b));
+    }
+
+    /// @brief Evaluates an elementwise expression (see GraphExpr.hpp) in a single pass with a single
+    /// allocation: entry by entry over the dense matrices, or, when every operand is stored as CSR,
+    /// row by row merging their edges. The result uses the resource of the leftmost operand and
+    /// the representation that suits its density.
+    template <typename W>
+    template <typename E>
+    BasicGraph<W>::BasicGraph(const GraphExpr<W, E> &expression) : BasicGraph(expression.self().resource())
+    {
+        const E &entries = expression.self();
+        vertices = entries.size();
+        resetCounts();
+        if (entries.allSparse())
+        {
+            representation = Representation::Sparse;
+            offsets = allocate<size_t>(vertices + 1, 0);
+            columns = allocate<size_t>(entries.edgeBound());
+            weights = allocate<W>(entries.edgeBound());
+            size_t *rowStart = offsets.data();
+            size_t *column = columns.data();
+            W *weight = weights.data();
+            size_t e = 0;
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                rowStart[i] = e;
+                entries.startRow(i);
+                for (size_t col = entries.nextColumn(); col != NO_COLUMN; col = entries.nextColumn())
+                {
+                    W value = entries.valueAt(col);
+                    entries.advancePast(col);
+                    if (value != 0)
+                    {
+                        column[e] = col;
+                        weight[e] = value;
+                        countEdge(i, col);
+                        ++e;
+                    }
+                }
+            }
+            rowStart[vertices] = e;
+            columns.shrink(e);
+            weights.shrink(e);
+        }
+        else
+        {
+            representation = Representation::Dense;
+            cells = allocate<W>(vertices * vertices);
+            entries.prepareDense();
+            W *out = cells.data();
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                W *row = out + i * vertices;
+                for (size_t j = 0; j < vertices; j += EXPRESSION_BLOCK)
+                {
+                    size_t count = min(EXPRESSION_BLOCK, vertices - j);
+                    const W *values = entries.block(i * vertices + j, count, row + j);
+                    if (values != row + j)
+                    {
+                        copy(values, values + count, row + j);
+                    }
+                }
+                countRow(i, row);
+            }
+        }
+        chooseRepresentation();
+    }
+
+    // The weight types Graph.cpp instantiates
+    extern template class BasicGraph<int8_t>;
+    extern template class BasicGraph<int16_t>;
+    extern template class BasicGraph<int32_t>;
+    extern template class BasicGraph<int64_t>;
+    extern template class BasicGraph<float>;
+    extern template class BasicGraph<double>;
+
+    using Graph = BasicGraph<int>;
 } // namespace ariel
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "GraphView.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <ostream>
+#include <stdexcept>
+
+namespace ariel
+{
+    template <typename W>
+    class BasicGraph;
+
+    /// @brief Base of the lazy elementwise graph expressions: sums and differences of graphs, and
+    /// their scalings. An expression only records its operands; turning it into a BasicGraph
+    /// (assigning or initializing one) evaluates every entry in one pass into one new matrix.
+    /// Operands are held by reference, so an expression must be evaluated within the statement
+    /// that builds it; never keep one in an `auto` variable.
+    ///
+    /// Every expression type E provides, for the evaluating BasicGraph constructor:
+    ///   size(), resource()                 size of the operands and the resource of the leftmost one
+    ///   edgeBound()                        an upper bound on the non-zero entries of the result
+    ///   allSparse()                        true if every operand is stored as CSR
+    ///   prepareDense(), block(k, count,    dense evaluation: entries [k, k + count) of the row-major
+    ///     out)                             result, either in an operand's matrix or written to out
+    ///   startRow(i), nextColumn(),         sparse evaluation: merges the rows of the operands, one
+    ///   valueAt(col), advancePast(col)     column at a time in ascending order
+    template <typename W, typename E>
+    class GraphExpr
+    {
+    public:
+        const E &self() const { return static_cast<const E &>(*this); }
+    };
+
+    // Column returned by nextColumn() once a row has no entries left
+    constexpr size_t NO_COLUMN = std::numeric_limits<size_t>::max();
+
+    // Dense evaluation works through the result EXPRESSION_BLOCK entries at a time, so that the
+    // intermediate values of a long expression stay in L1 and every step is one SIMD kernel call
+    constexpr size_t EXPRESSION_BLOCK = 256;
+
+    /// @brief A graph used as an operand of an expression.
+    template <typename W>
+    class GraphTerm : public GraphExpr<W, GraphTerm<W>>
+    {
+    private:
+        const BasicGraph<W> &graph;
+        mutable const W *cells = nullptr; // dense evaluation: the graph's matrix, or scratch
+        mutable Buffer<W> scratch;        // dense evaluation of a sparse graph: its expanded matrix
+        mutable size_t next = 0;          // sparse evaluation: the next edge of the current row
+        mutable size_t last = 0;          // sparse evaluation: the end of the current row
+
+    public:
+        explicit GraphTerm(const BasicGraph<W> &graph) : graph(graph) {}
+
+        size_t size() const { return graph.vertices; }
+        std::pmr::memory_resource *resource() const { return graph.resource; }
+        size_t edgeBound() const { return graph.edgeCount; }
+        bool allSparse() const { return graph.representation == Representation::Sparse; }
+
+        void prepareDense() const { cells = graph.denseCells(scratch); }
+        const W *block(size_t k, size_t, W *) const { return cells + k; }
+
+        void startRow(size_t row) const
+        {
+            next = graph.offsets[row];
+            last = graph.offsets[row + 1];
+        }
+        size_t nextColumn() const { return next < last ? graph.columns[next] : NO_COLUMN; }
+        W valueAt(size_t col) const { return next < last && graph.columns[next] == col ? graph.weights[next] : W(0); }
+        void advancePast(size_t col) const
+        {
+            if (next < last && graph.columns[next] == col)
+            {
+                ++next;
+            }
+        }
+    };
+
+    struct AddWeights
+    {
+        template <typename W>
+        W operator()(W a, W b) const { return W(a + b); }
+
+        // out = a + b, where a is either out itself or does not overlap it
+        template <typename W>
+        static void apply(const W *a, const W *b, W *out, size_t count)
+        {
+            a == out ? simd::addTo(out, b, count) : simd::add(a, b, out, count);
+        }
+    };
+
+    struct SubtractWeights
+    {
+        template <typename W>
+        W operator()(W a, W b) const { return W(a - b); }
+
+        // out = a - b, where a is either out itself or does not overlap it
+        template <typename W>
+        static void apply(const W *a, const W *b, W *out, size_t count)
+        {
+            a == out ? simd::subtractFrom(out, b, count) : simd::subtract(a, b, out, count);
+        }
+    };
+
+    /// @brief The entrywise sum or difference of two expressions of the same size.
+    template <typename W, typename L, typename R, typename Operation>
+    class GraphBinary : public GraphExpr<W, GraphBinary<W, L, R, Operation>>
+    {
+    private:
+        L left;
+        R right;
+
+    public:
+        GraphBinary(const L &left, const R &right, const char *sizeError) : left(left), right(right)
+        {
+            if (left.size() != right.size() || left.size() == 0)
+            {
+                throw std::runtime_error(sizeError);
+            }
+        }
+
+        size_t size() const { return left.size(); }
+        std::pmr::memory_resource *resource() const { return left.resource(); }
+        size_t edgeBound() const { return left.edgeBound() + right.edgeBound(); }
+        bool allSparse() const { return left.allSparse() && right.allSparse(); }
+
+        void prepareDense() const
+        {
+            left.prepareDense();
+            right.prepareDense();
+        }
+        const W *block(size_t k, size_t count, W *out) const
+        {
+            W scratch[EXPRESSION_BLOCK];
+            const W *a = left.block(k, count, out);
+            const W *b = right.block(k, count, scratch);
+            Operation::apply(a, b, out, count);
+            return out;
+        }
+
+        void startRow(size_t row) const
+        {
+            left.startRow(row);
+            right.startRow(row);
+        }
+        size_t nextColumn() const { return std::min(left.nextColumn(), right.nextColumn()); }
+        W valueAt(size_t col) const { return Operation()(left.valueAt(col), right.valueAt(col)); }
+        void advancePast(size_t col) const
+        {
+            left.advancePast(col);
+            right.advancePast(col);
+        }
+    };
+
+    /// @brief An expression with every entry multiplied by a scalar.
+    template <typename W, typename E>
+    class GraphScaled : public GraphExpr<W, GraphScaled<W, E>>
+    {
+    private:
+        E operand;
+        W factor;
+
+    public:
+        GraphScaled(const E &operand, W factor) : operand(operand), factor(factor) {}
+
+        size_t size() const { return operand.size(); }
+        std::pmr::memory_resource *resource() const { return operand.resource(); }
+        size_t edgeBound() const { return operand.edgeBound(); }
+        bool allSparse() const { return operand.allSparse(); }
+
+        void prepareDense() const { operand.prepareDense(); }
+        const W *block(size_t k, size_t count, W *out) const
+        {
+            const W *a = operand.block(k, count, out);
+            a == out ? simd::scale(out, factor, count) : simd::scale(a, factor, out, count);
+            return out;
+        }
+
+        void startRow(size_t row) const { operand.startRow(row); }
+        size_t nextColumn() const { return operand.nextColumn(); }
+        W valueAt(size_t col) const { return W(operand.valueAt(col) * factor); }
+        void advancePast(size_t col) const { operand.advancePast(col); }
+    };
+
+    template <typename W>
+    using GraphSum = GraphBinary<W, GraphTerm<W>, GraphTerm<W>, AddWeights>;
+    template <typename W>
+    using GraphDifference = GraphBinary<W, GraphTerm<W>, GraphTerm<W>, SubtractWeights>;
+
+    // Keeps a parameter out of template argument deduction, so that `expression * 2` works for any W
+    template <typename T>
+    struct NonDeduced
+    {
+        using type = T;
+    };
+
+    // The operators that build expressions. graph + graph, graph - graph and graph * scalar are members
+    // of BasicGraph; only the compound assignments +=, -= and *= modify a graph. Member functions such
+    // as getEdges() or pow() are not available on an expression: evaluate it into a graph first.
+
+    template <typename W, typename L, typename R>
+    GraphBinary<W, L, R, AddWeights> operator+(const GraphExpr<W, L> &left, const GraphExpr<W, R> &right)
+    {
+        return GraphBinary<W, L, R, AddWeights>(left.self(), right.self(), "Graphs of different sizes cannot be added");
+    }
+
+    template <typename W, typename L>
+    GraphBinary<W, L, GraphTerm<W>, AddWeights> operator+(const GraphExpr<W, L> &left, const BasicGraph<W> &right)
+    {
+        return GraphBinary<W, L, GraphTerm<W>, AddWeights>(left.self(), GraphTerm<W>(right), "Graphs of different sizes cannot be added");
+    }
+
+    template <typename W, typename R>
+    GraphBinary<W, GraphTerm<W>, R, AddWeights> operator+(const BasicGraph<W> &left, const GraphExpr<W, R> &right)
+    {
+        return GraphBinary<W, GraphTerm<W>, R, AddWeights>(GraphTerm<W>(left), right.self(), "Graphs of different sizes cannot be added");
+    }
+
+    template <typename W, typename L, typename R>
+    GraphBinary<W, L, R, SubtractWeights> operator-(const GraphExpr<W, L> &left, const GraphExpr<W, R> &right)
+    {
+        return GraphBinary<W, L, R, SubtractWeights>(left.self(), right.self(), "Graphs of different sizes cannot be subtracted");
+    }
+
+    template <typename W, typename L>
+    GraphBinary<W, L, GraphTerm<W>, SubtractWeights> operator-(const GraphExpr<W, L> &left, const BasicGraph<W> &right)
+    {
+        return GraphBinary<W, L, GraphTerm<W>, SubtractWeights>(left.self(), GraphTerm<W>(right), "Graphs of different sizes cannot be subtracted");
+    }
+
+    template <typename W, typename R>
+    GraphBinary<W, GraphTerm<W>, R, SubtractWeights> operator-(const BasicGraph<W> &left, const GraphExpr<W, R> &right)
+    {
+        return GraphBinary<W, GraphTerm<W>, R, SubtractWeights>(GraphTerm<W>(left), right.self(), "Graphs of different sizes cannot be subtracted");
+    }
+
+    template <typename W, typename E>
+    GraphScaled<W, E> operator*(const GraphExpr<W, E> &operand, typename NonDeduced<W>::type factor)
+    {
+        return GraphScaled<W, E>(operand.self(), factor);
+    }
+
+    // Comparing or printing an expression evaluates it first
+
+    template <typename W, typename E>
+    bool operator==(const GraphExpr<W, E> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) == right; }
+    template <typename W, typename E>
+    bool operator!=(const GraphExpr<W, E> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) != right; }
+    template <typename W, typename E>
+    bool operator>(const GraphExpr<W, E> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) > right; }
+    template <typename W, typename E>
+    bool operator<(const GraphExpr<W, E> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) < right; }
+    template <typename W, typename E>
+    bool operator>=(const GraphExpr<W, E> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) >= right; }
+    template <typename W, typename E>
+    bool operator<=(const GraphExpr<W, E> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) <= right; }
+
+    template <typename W, typename E>
+    std::ostream &operator<<(std::ostream &os, const GraphExpr<W, E> &expression)
+    {
+        return os << BasicGraph<W>(expression);
+    }
+
+    // So does multiplying one as a matrix
+
+    template <typename W, typename L>
+    BasicGraph<W> operator*(const GraphExpr<W, L> &left, const BasicGraph<W> &right) { return BasicGraph<W>(left) * right; }
+    template <typename W, typename R>
+    BasicGraph<W> operator*(const BasicGraph<W> &left, const GraphExpr<W, R> &right) { return left * BasicGraph<W>(right); }
+    template <typename W, typename L, typename R>
+    BasicGraph<W> operator*(const GraphExpr<W, L> &left, const GraphExpr<W, R> &right)
+    {
+        return BasicGraph<W>(left) * BasicGraph<W>(right);
+    }
+} // namespace ariel
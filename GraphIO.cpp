@@ -0,0 +1,668 @@
+#include "Graph.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using ariel::BasicGraph;
+using ariel::Buffer;
+using ariel::LoadStats;
+using ariel::parallelFor;
+using ariel::threadCount;
+using ariel::Representation;
+
+/*
+ * Binary graph file layout (version 1, native byte order):
+ *
+ *   FileHeader                        64 bytes
+ *   dense:  cells      n * n  weights
+ *   sparse: offsets    n + 1  uint64
+ *           columns    edges  uint64
+ *           weights    edges  weights
+ *   outDegrees         n      uint64
+ *   inDegrees          n      uint64
+ *
+ * Every array starts on a 64-byte boundary (zero padding in between), so a mapped
+ * file can be used in place with the same alignment as a freshly allocated graph.
+ */
+
+namespace
+{
+    const char FILE_MAGIC[8] = {'A', 'R', 'I', 'E', 'L', 'G', 'R', 'F'};
+    const uint32_t FILE_VERSION = 1;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const size_t FILE_ALIGNMENT = 64;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;      // BYTE_ORDER_MARK as written by the saving machine
+        uint8_t representation;  // 0 dense, 1 sparse
+        uint8_t weightType;      // byte width of a weight, plus 0x10 for floating point
+        uint8_t reserved[6];
+        uint64_t vertices;
+        uint64_t edges;
+        uint8_t padding[24];
+    };
+    static_assert(sizeof(FileHeader) == FILE_ALIGNMENT, "The header must fill exactly one aligned block");
+    static_assert(sizeof(size_t) == sizeof(uint64_t), "Offsets and columns are stored as 64-bit values");
+
+    template <typename W>
+    uint8_t weightTypeOf()
+    {
+        return uint8_t((is_floating_point<W>::value ? 0x10 : 0) | sizeof(W));
+    }
+
+    size_t alignUp(size_t bytes)
+    {
+        return (bytes + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+    }
+
+    // Byte offsets of every array in the file, in file order. The sizes come from a file header,
+    // so every step is checked: overflowed is set if any of them does not fit in a size_t.
+    struct FileLayout
+    {
+        size_t cells = 0;
+        size_t offsets = 0;
+        size_t columns = 0;
+        size_t weights = 0;
+        size_t outDegrees = 0;
+        size_t inDegrees = 0;
+        size_t total = 0;
+        bool overflowed = false;
+
+        FileLayout(Representation representation, size_t vertices, size_t edges, size_t weightSize)
+        {
+            size_t position = sizeof(FileHeader);
+            if (representation == Representation::Dense)
+            {
+                cells = position;
+                position = alignUp(advance(position, multiply(multiply(vertices, vertices), weightSize)));
+            }
+            else
+            {
+                offsets = position;
+                position = alignUp(advance(position, multiply(advance(vertices, 1), sizeof(size_t))));
+                columns = position;
+                position = alignUp(advance(position, multiply(edges, sizeof(size_t))));
+                weights = position;
+                position = alignUp(advance(position, multiply(edges, weightSize)));
+            }
+            outDegrees = position;
+            position = alignUp(advance(position, multiply(vertices, sizeof(size_t))));
+            inDegrees = position;
+            total = advance(position, multiply(vertices, sizeof(size_t)));
+        }
+
+    private:
+        // Keeps results at least FILE_ALIGNMENT below the maximum, so that alignUp cannot wrap either
+        static constexpr size_t LIMIT = numeric_limits<size_t>::max() - FILE_ALIGNMENT;
+
+        size_t multiply(size_t a, size_t b)
+        {
+            size_t product;
+            if (__builtin_mul_overflow(a, b, &product) || product > LIMIT)
+            {
+                overflowed = true;
+                return LIMIT;
+            }
+            return product;
+        }
+
+        size_t advance(size_t a, size_t b)
+        {
+            size_t sum;
+            if (__builtin_add_overflow(a, b, &sum) || sum > LIMIT)
+            {
+                overflowed = true;
+                return LIMIT;
+            }
+            return sum;
+        }
+    };
+
+    // Checks that the arrays of a mapped graph describe a well-formed graph of vertices vertices and edges edges,
+    // so that no later access can leave them: the CSR offsets rise from 0 to edges, each row's columns are in range
+    // and strictly ascending with non-zero weights, and the stored degrees match a recount. O(n + m) when sparse,
+    // one pass over the matrix when dense.
+    template <typename W>
+    bool wellFormed(Representation representation, size_t vertices, size_t edges, const W *cells, const size_t *offsets,
+                    const size_t *columns, const W *weights, const size_t *outDegrees, const size_t *inDegrees)
+    {
+        vector<size_t> counted(vertices, 0); // in-degrees, recounted
+        size_t total = 0;
+        if (representation == Representation::Dense)
+        {
+            if (vertices != 0 && edges > vertices * vertices)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                size_t degree = ariel::simd::countNonZero(cells + i * vertices, vertices, counted.data());
+                if (degree != outDegrees[i])
+                {
+                    return false;
+                }
+                total += degree;
+            }
+        }
+        else
+        {
+            if (offsets[0] != 0 || offsets[vertices] != edges)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                size_t first = offsets[i];
+                size_t last = offsets[i + 1];
+                if (last < first || last > edges || last - first != outDegrees[i])
+                {
+                    return false;
+                }
+                for (size_t e = first; e < last; ++e)
+                {
+                    if (columns[e] >= vertices || (e > first && columns[e] <= columns[e - 1]) || weights[e] == 0)
+                    {
+                        return false;
+                    }
+                    ++counted[columns[e]];
+                }
+                total += last - first;
+            }
+        }
+        return total == edges && equal(counted.begin(), counted.end(), inDegrees);
+    }
+
+    template <typename T>
+    void writeArray(ofstream &file, const T *data, size_t count)
+    {
+        file.write(reinterpret_cast<const char *>(data), streamsize(count * sizeof(T)));
+        static const char zeros[FILE_ALIGNMENT] = {};
+        size_t written = size_t(file.tellp());
+        file.write(zeros, streamsize(alignUp(written) - written));
+    }
+
+    // Maps a whole file into memory. A writable mapping is private: writes never reach the file.
+    shared_ptr<void> mapWholeFile(const string &path, bool writable, size_t &size)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw runtime_error("Cannot open " + path);
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size <= 0)
+        {
+            close(fd);
+            throw runtime_error(path + " is empty or unreadable");
+        }
+        size = size_t(status.st_size);
+        void *address = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+        {
+            throw runtime_error("Cannot map " + path);
+        }
+        size_t length = size;
+        return shared_ptr<void>(address, [length](void *pointer)
+                                { munmap(pointer, length); });
+    }
+
+    // Wraps an array inside a mapped file. Every array holds a reference to the mapping,
+    // which is unmapped when the last of them is released.
+    template <typename T>
+    Buffer<T> mappedArray(const shared_ptr<void> &mapping, size_t offset, size_t count)
+    {
+        T *data = reinterpret_cast<T *>(static_cast<char *>(mapping.get()) + offset);
+        return Buffer<T>(data, count, [mapping](T *) {});
+    }
+
+    // One "row column [weight]" line of a text file, with 0-based indices
+    template <typename W>
+    struct TextEntry
+    {
+        size_t row;
+        size_t col;
+        W weight;
+    };
+
+    // How the entry lines of a text file are to be read
+    struct TextFormat
+    {
+        size_t indexBase = 0;   // 1 for Matrix Market
+        bool weighted = true;   // false for Matrix Market "pattern" files: every entry weighs 1
+        int mirror = 0;         // 1 (symmetric) or -1 (skew-symmetric) adds the transposed entry, negated for -1
+    };
+
+    const char *skipBlanks(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    // The start of the line after the one ending at lineEnd, or end if lineEnd is end: never a pointer past the mapping
+    const char *nextLine(const char *lineEnd, const char *end)
+    {
+        return lineEnd == end ? end : lineEnd + 1;
+    }
+
+    // Parses the entry lines in [begin, end), skipping blank lines and '#' or '%' comments.
+    // Returns the number of entry lines, which mirrored entries of symmetric files outnumber.
+    template <typename W>
+    size_t parseEntries(const char *begin, const char *end, const char *fileStart, const TextFormat &format, vector<TextEntry<W>> &entries)
+    {
+        size_t lines = 0;
+        const char *p = begin;
+        while (p < end)
+        {
+            const char *lineEnd = find(p, end, '\n');
+            p = skipBlanks(p, lineEnd);
+            if (p == lineEnd || *p == '#' || *p == '%')
+            {
+                p = nextLine(lineEnd, end);
+                continue;
+            }
+            const char *lineStart = p;
+            size_t row = 0;
+            size_t col = 0;
+            W weight = 1;
+            from_chars_result parsed = from_chars(p, lineEnd, row);
+            bool ok = parsed.ec == errc() && parsed.ptr != p;
+            if (ok)
+            {
+                p = skipBlanks(parsed.ptr, lineEnd);
+                parsed = from_chars(p, lineEnd, col);
+                ok = parsed.ec == errc() && parsed.ptr != p;
+                p = skipBlanks(parsed.ptr, lineEnd);
+            }
+            if (ok && format.weighted && p < lineEnd)
+            {
+                parsed = from_chars(p, lineEnd, weight);
+                ok = parsed.ec == errc() && parsed.ptr != p;
+                p = skipBlanks(parsed.ptr, lineEnd);
+            }
+            ok = ok && p == lineEnd && row >= format.indexBase && col >= format.indexBase;
+            if (!ok)
+            {
+                throw runtime_error("Malformed entry at byte " + to_string(lineStart - fileStart));
+            }
+            row -= format.indexBase;
+            col -= format.indexBase;
+            ++lines;
+            entries.push_back({row, col, weight});
+            if (format.mirror != 0 && row != col)
+            {
+                entries.push_back({col, row, format.mirror > 0 ? weight : W(-weight)});
+            }
+            p = nextLine(lineEnd, end);
+        }
+        return lines;
+    }
+
+    // Parses the entry lines of [begin, end) on every thread, one newline-aligned chunk each,
+    // and adds the number of entry lines to lines
+    template <typename W>
+    vector<vector<TextEntry<W>>> parseInParallel(const char *begin, const char *end, const char *fileStart, const TextFormat &format, size_t &lines)
+    {
+        size_t chunks = threadCount();
+        vector<const char *> bounds(chunks + 1, end);
+        bounds[0] = begin;
+        for (size_t c = 1; c < chunks; ++c)
+        {
+            const char *guess = begin + size_t(end - begin) * c / chunks;
+            bounds[c] = guess <= bounds[c - 1] ? bounds[c - 1] : nextLine(find(guess, end, '\n'), end);
+        }
+        vector<vector<TextEntry<W>>> entries(chunks);
+        vector<size_t> counts(chunks, 0);
+        parallelFor(0, chunks, [&](size_t first, size_t last)
+                    {
+                        for (size_t c = first; c < last; ++c)
+                        {
+                            counts[c] = parseEntries(bounds[c], bounds[c + 1], fileStart, format, entries[c]);
+                        } });
+        for (size_t count : counts)
+        {
+            lines += count;
+        }
+        return entries;
+    }
+
+    string lowercase(string text)
+    {
+        transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                  { return char(tolower(c)); });
+        return text;
+    }
+} // namespace
+
+// Function to build a CSR graph straight from parsed entries. Entries for the same cell are summed
+// and entries that end up zero are dropped; the representation is then chosen by density.
+template <typename W>
+template <typename Chunks>
+void BasicGraph<W>::loadEntries(size_t n, Chunks &chunks)
+{
+    BasicGraph loaded(resource);
+    loaded.vertices = n;
+    loaded.representation = Representation::Sparse;
+    loaded.resetCounts();
+    loaded.offsets = allocate<size_t>(n + 1, 0);
+    for (const auto &chunk : chunks)
+    {
+        for (const auto &entry : chunk)
+        {
+            if (entry.row >= n || entry.col >= n)
+            {
+                throw runtime_error("Entry (" + to_string(entry.row) + ", " + to_string(entry.col) + ") is outside the matrix");
+            }
+            ++loaded.offsets[entry.row + 1];
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        loaded.offsets[i + 1] += loaded.offsets[i];
+    }
+    loaded.columns = allocate<size_t>(loaded.offsets[n]);
+    loaded.weights = allocate<W>(loaded.offsets[n]);
+    vector<size_t> cursor(loaded.offsets.begin(), loaded.offsets.end() - 1);
+    for (auto &chunk : chunks)
+    {
+        for (const auto &entry : chunk)
+        {
+            size_t e = cursor[entry.row]++;
+            loaded.columns[e] = entry.col;
+            loaded.weights[e] = entry.weight;
+        }
+        chunk.clear();
+        chunk.shrink_to_fit();
+    }
+
+    // Sort every row by column and merge duplicates in place, remembering the new row lengths
+    vector<size_t> lengths(n, 0);
+    parallelFor(0, n, [&](size_t first, size_t last)
+                {
+                    vector<pair<size_t, W>> row;
+                    for (size_t i = first; i < last; ++i)
+                    {
+                        size_t begin = loaded.offsets[i];
+                        size_t end = loaded.offsets[i + 1];
+                        row.clear();
+                        for (size_t e = begin; e < end; ++e)
+                        {
+                            row.emplace_back(loaded.columns[e], loaded.weights[e]);
+                        }
+                        sort(row.begin(), row.end(), [](const pair<size_t, W> &a, const pair<size_t, W> &b)
+                             { return a.first < b.first; });
+                        size_t out = begin;
+                        for (size_t k = 0; k < row.size();)
+                        {
+                            size_t col = row[k].first;
+                            W sum = 0;
+                            for (; k < row.size() && row[k].first == col; ++k)
+                            {
+                                sum = W(sum + row[k].second);
+                            }
+                            if (sum != 0)
+                            {
+                                loaded.columns[out] = col;
+                                loaded.weights[out] = sum;
+                                ++out;
+                            }
+                        }
+                        lengths[i] = out - begin;
+                    } }, 1024);
+
+    // Close the gaps left by merged entries
+    size_t e = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t begin = loaded.offsets[i];
+        loaded.offsets[i] = e;
+        for (size_t k = begin; k < begin + lengths[i]; ++k, ++e)
+        {
+            loaded.columns[e] = loaded.columns[k];
+            loaded.weights[e] = loaded.weights[k];
+            loaded.countEdge(i, loaded.columns[e]);
+        }
+    }
+    loaded.offsets[n] = e;
+    loaded.columns.shrink(e);
+    loaded.weights.shrink(e);
+    loaded.chooseRepresentation();
+    *this = std::move(loaded);
+}
+
+// Function to load an edge list: one "source target [weight]" line per edge, 0-based vertex ids,
+// weight 1 when omitted, '#' or '%' comment lines. The graph has max(id) + 1 vertices.
+// The file is parsed in parallel, straight into CSR.
+template <typename W>
+LoadStats BasicGraph<W>::loadEdgeList(const string &path)
+{
+    auto started = chrono::steady_clock::now();
+    size_t size = 0;
+    shared_ptr<void> mapping = mapWholeFile(path, false, size);
+    const char *text = static_cast<const char *>(mapping.get());
+    size_t rows = 0;
+    auto chunks = parseInParallel<W>(text, text + size, text, TextFormat(), rows);
+
+    size_t n = 0;
+    for (const auto &chunk : chunks)
+    {
+        for (const auto &entry : chunk)
+        {
+            n = max(n, max(entry.row, entry.col) + 1);
+        }
+    }
+    if (n == 0)
+    {
+        throw runtime_error(path + " has no edges");
+    }
+    loadEntries(n, chunks);
+
+    LoadStats stats;
+    stats.bytes = size;
+    stats.rows = rows;
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return stats;
+}
+
+// Function to load a Matrix Market coordinate file (real, integer or pattern; general,
+// symmetric or skew-symmetric). The banner and size line are read first, then the entries
+// are parsed in parallel, straight into CSR.
+template <typename W>
+LoadStats BasicGraph<W>::loadMatrixMarket(const string &path)
+{
+    auto started = chrono::steady_clock::now();
+    size_t size = 0;
+    shared_ptr<void> mapping = mapWholeFile(path, false, size);
+    const char *text = static_cast<const char *>(mapping.get());
+    const char *end = text + size;
+
+    const char *line = text;
+    const char *lineEnd = find(line, end, '\n');
+    istringstream banner(string(line, lineEnd));
+    string tag, object, layout, field, symmetry;
+    banner >> tag >> object >> layout >> field >> symmetry;
+    field = lowercase(field);
+    symmetry = lowercase(symmetry);
+    if (tag != "%%MatrixMarket" || lowercase(object) != "matrix" || lowercase(layout) != "coordinate")
+    {
+        throw runtime_error(path + " is not a Matrix Market coordinate file");
+    }
+    TextFormat format;
+    format.indexBase = 1;
+    format.weighted = field != "pattern";
+    format.mirror = symmetry == "symmetric" ? 1 : symmetry == "skew-symmetric" ? -1 : 0;
+    if ((field != "real" && field != "integer" && field != "pattern") ||
+        (symmetry != "general" && format.mirror == 0))
+    {
+        throw runtime_error(path + ": unsupported Matrix Market type " + field + " " + symmetry);
+    }
+
+    // Skip the comments up to the "rows columns entries" size line
+    size_t rowCount = 0;
+    size_t columnCount = 0;
+    size_t entryCount = 0;
+    for (line = nextLine(lineEnd, end); line < end; line = nextLine(lineEnd, end))
+    {
+        lineEnd = find(line, end, '\n');
+        const char *p = skipBlanks(line, lineEnd);
+        if (p == lineEnd || *p == '%')
+        {
+            continue;
+        }
+        istringstream sizes(string(p, lineEnd));
+        if (!(sizes >> rowCount >> columnCount >> entryCount))
+        {
+            throw runtime_error(path + ": malformed size line");
+        }
+        break;
+    }
+    if (rowCount == 0 || rowCount != columnCount)
+    {
+        throw runtime_error("Invalid adjacency matrix: not square");
+    }
+
+    const char *body = nextLine(lineEnd, end);
+    size_t rows = 0;
+    auto chunks = parseInParallel<W>(body, end, text, format, rows);
+    if (rows != entryCount)
+    {
+        throw runtime_error(path + ": the size line announces " + to_string(entryCount) + " entries but " + to_string(rows) + " were found");
+    }
+    loadEntries(rowCount, chunks);
+
+    LoadStats stats;
+    stats.bytes = size;
+    stats.rows = rows;
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return stats;
+}
+
+// Function to write the graph to a binary file that mapFile() can map back
+template <typename W>
+void BasicGraph<W>::save(const string &path) const
+{
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file)
+    {
+        throw runtime_error("Cannot open " + path + " for writing");
+    }
+    FileHeader header = {};
+    memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.representation = representation == Representation::Dense ? 0 : 1;
+    header.weightType = weightTypeOf<W>();
+    header.vertices = vertices;
+    header.edges = edgeCount;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (representation == Representation::Dense)
+    {
+        writeArray(file, cells.data(), cells.size());
+    }
+    else
+    {
+        writeArray(file, offsets.data(), offsets.size());
+        writeArray(file, columns.data(), columns.size());
+        writeArray(file, weights.data(), weights.size());
+    }
+    writeArray(file, outDegrees.data(), outDegrees.size());
+    writeArray(file, inDegrees.data(), inDegrees.size());
+    if (!file)
+    {
+        throw runtime_error("Failed writing " + path);
+    }
+}
+
+// Function to replace the graph with one saved by save(), mapped into memory instead of read.
+// The arrays are used in place rather than copied, and their pages are only read when a query
+// touches them. The checks made when mapping are O(1): the header, the array sizes against the
+// file length and the two ends of the CSR offsets. With validate, every array is also checked in
+// one O(n + m) pass (one pass over the matrix when dense) before being adopted, which reads the
+// whole file: CSR offsets or columns out of range and degree counts that do not match are
+// rejected, so a corrupt file cannot lead to reads outside the mapping. Map a file from an
+// untrusted source only with validate. The file is mapped privately: it is never modified, and
+// operators that mutate the graph write to private copies of the pages they touch.
+template <typename W>
+void BasicGraph<W>::mapFile(const string &path, bool validate)
+{
+    size_t fileSize = 0;
+    shared_ptr<void> mapping = mapWholeFile(path, true, fileSize);
+    if (fileSize < sizeof(FileHeader))
+    {
+        throw runtime_error(path + " is not a graph file");
+    }
+    const FileHeader &header = *static_cast<const FileHeader *>(mapping.get());
+    if (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK || header.representation > 1)
+    {
+        throw runtime_error(path + " is not a version " + to_string(FILE_VERSION) + " graph file for this machine");
+    }
+    if (header.weightType != weightTypeOf<W>())
+    {
+        throw runtime_error(path + " holds a different weight type");
+    }
+    size_t n = size_t(header.vertices);
+    size_t edges = size_t(header.edges);
+    Representation storage = header.representation == 0 ? Representation::Dense : Representation::Sparse;
+    FileLayout layout(storage, n, edges, sizeof(W));
+    if (layout.overflowed || layout.total > fileSize || (storage == Representation::Dense && edges > n * n))
+    {
+        throw runtime_error(path + " is truncated or its header is corrupt");
+    }
+
+    BasicGraph loaded(resource);
+    loaded.vertices = n;
+    loaded.representation = storage;
+    if (storage == Representation::Dense)
+    {
+        loaded.cells = mappedArray<W>(mapping, layout.cells, n * n);
+    }
+    else
+    {
+        loaded.offsets = mappedArray<size_t>(mapping, layout.offsets, n + 1);
+        loaded.columns = mappedArray<size_t>(mapping, layout.columns, edges);
+        loaded.weights = mappedArray<W>(mapping, layout.weights, edges);
+    }
+    loaded.edgeCount = edges;
+    loaded.outDegrees = mappedArray<size_t>(mapping, layout.outDegrees, n);
+    loaded.inDegrees = mappedArray<size_t>(mapping, layout.inDegrees, n);
+    if (storage == Representation::Sparse && (loaded.offsets[0] != 0 || loaded.offsets[n] != edges))
+    {
+        throw runtime_error(path + " holds a malformed graph");
+    }
+    if (validate && !wellFormed(storage, n, edges, loaded.cells.data(), loaded.offsets.data(), loaded.columns.data(),
+                                loaded.weights.data(), loaded.outDegrees.data(), loaded.inDegrees.data()))
+    {
+        throw runtime_error(path + " holds a malformed graph");
+    }
+    *this = std::move(loaded);
+}
+
+// The supported weight types
+#define ARIEL_INSTANTIATE_GRAPH_IO(W)                            \
+    template void BasicGraph<W>::save(const string &path) const; \
+    template void BasicGraph<W>::mapFile(const string &path, bool validate); \
+    template LoadStats BasicGraph<W>::loadEdgeList(const string &path); \
+    template LoadStats BasicGraph<W>::loadMatrixMarket(const string &path);
+
+ARIEL_INSTANTIATE_GRAPH_IO(int8_t)
+ARIEL_INSTANTIATE_GRAPH_IO(int16_t)
+ARIEL_INSTANTIATE_GRAPH_IO(int32_t)
+ARIEL_INSTANTIATE_GRAPH_IO(int64_t)
+ARIEL_INSTANTIATE_GRAPH_IO(float)
+ARIEL_INSTANTIATE_GRAPH_IO(double)
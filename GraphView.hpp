@@ -0,0 +1,230 @@
+#pragma once
+
+#include "BitMatrix.hpp"
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace ariel
+{
+    using std::size_t;
+
+    /// @brief How the adjacency matrix is stored in memory.
+    enum class Representation
+    {
+        Dense, // n x n row-major matrix
+        Sparse // compressed sparse row (offsets, column indices, weights)
+    };
+
+    /// @brief A single outgoing edge, as produced by iterating over neighbors().
+    template <typename W>
+    struct Edge
+    {
+        size_t to;
+        W weight;
+    };
+
+    /// @brief Iterates over the non-zero entries of one row, whatever the representation.
+    template <typename W>
+    class NeighborIterator
+    {
+    private:
+        const W *row;          // dense row, or nullptr for a sparse row
+        const size_t *columns; // sparse column indices
+        const W *weights;      // sparse weights
+        size_t position;       // column (dense) or index into columns/weights (sparse)
+        size_t limit;
+
+        void skipZeros()
+        {
+            if (row != nullptr)
+            {
+                while (position < limit && row[position] == 0)
+                {
+                    ++position;
+                }
+            }
+        }
+
+    public:
+        NeighborIterator(const W *row, const size_t *columns, const W *weights, size_t position, size_t limit)
+            : row(row), columns(columns), weights(weights), position(position), limit(limit)
+        {
+            skipZeros();
+        }
+        Edge<W> operator*() const
+        {
+            return row != nullptr ? Edge<W>{position, row[position]} : Edge<W>{columns[position], weights[position]};
+        }
+        NeighborIterator &operator++()
+        {
+            ++position;
+            skipZeros();
+            return *this;
+        }
+        bool operator==(const NeighborIterator &other) const { return position == other.position; }
+        bool operator!=(const NeighborIterator &other) const { return position != other.position; }
+    };
+
+    /// @brief The outgoing edges of a vertex, usable in a range-based for loop.
+    template <typename W>
+    class NeighborRange
+    {
+    private:
+        NeighborIterator<W> first;
+        NeighborIterator<W> last;
+
+    public:
+        NeighborRange(NeighborIterator<W> first, NeighborIterator<W> last) : first(first), last(last) {}
+        NeighborIterator<W> begin() const { return first; }
+        NeighborIterator<W> end() const { return last; }
+    };
+
+    /// @brief The smallest and largest edge weights of a graph, both 0 if it has no edges.
+    template <typename W>
+    struct WeightRange
+    {
+        W smallest = 0;
+        W largest = 0;
+
+        bool nonNegative() const { return smallest >= 0; }
+    };
+
+    template <typename W>
+    class BasicGraph;
+
+    /// @brief A non-owning, read-only graph over memory owned elsewhere: a BasicGraph, an mmap'd file,
+    /// shared memory or a square sub-block of a larger matrix. It is a handful of pointers, cheap to copy,
+    /// and valid only as long as the memory it points to. Every Algorithms entry point accepts one.
+    template <typename W>
+    class GraphView
+    {
+    private:
+        size_t vertices = 0;
+        Representation representation = Representation::Dense;
+        const W *cells = nullptr;        // dense: first entry of row 0
+        size_t stride = 0;               // dense: distance in elements between consecutive rows
+        const size_t *offsets = nullptr; // sparse: vertices + 1 row offsets
+        const size_t *columns = nullptr; // sparse: column of each edge, ascending within a row
+        const W *weights = nullptr;      // sparse: weight of each edge
+        const BasicGraph<W> *owner = nullptr; // graph the view came from, whose caches it may use
+
+    public:
+        GraphView() = default;
+
+        /// @brief Views a dense row-major matrix. Row i starts at cells + i * stride; a stride of 0 means vertices.
+        GraphView(const W *cells, size_t vertices, size_t stride = 0)
+            : vertices(vertices), representation(Representation::Dense), cells(cells), stride(stride == 0 ? vertices : stride)
+        {
+        }
+
+        /// @brief Views a CSR matrix: row i's edges are columns/weights [offsets[i], offsets[i + 1]).
+        GraphView(const size_t *offsets, const size_t *columns, const W *weights, size_t vertices)
+            : vertices(vertices), representation(Representation::Sparse), offsets(offsets), columns(columns), weights(weights)
+        {
+        }
+
+        /// @brief The same view, remembering the graph it was taken from so its cached data can be reused.
+        GraphView(const GraphView &view, const BasicGraph<W> *owner) : GraphView(view)
+        {
+            this->owner = owner;
+        }
+
+        size_t getVertices() const { return vertices; }
+        Representation getRepresentation() const { return representation; }
+
+        /// @brief The outgoing edges (non-zero entries) of a vertex in ascending order.
+        /// Costs O(n) per row when dense and O(degree) when sparse.
+        NeighborRange<W> neighbors(size_t vertex) const
+        {
+            if (representation == Representation::Dense)
+            {
+                const W *first = cells + vertex * stride;
+                return NeighborRange<W>(NeighborIterator<W>(first, nullptr, nullptr, 0, vertices),
+                                        NeighborIterator<W>(first, nullptr, nullptr, vertices, vertices));
+            }
+            size_t begin = offsets[vertex];
+            size_t end = offsets[vertex + 1];
+            return NeighborRange<W>(NeighborIterator<W>(nullptr, columns, weights, begin, end),
+                                    NeighborIterator<W>(nullptr, columns, weights, end, end));
+        }
+
+        /// @brief Packs the adjacency into a BitMatrix (bit j of row i is set iff there is an edge i -> j).
+        BitMatrix toBitMatrix(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const
+        {
+            BitMatrix bits(vertices, resource);
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                if (representation == Representation::Dense)
+                {
+                    const W *row = cells + i * stride;
+                    std::uint64_t *out = bits.row(i);
+                    for (size_t j = 0; j < vertices; j += BitMatrix::WORD_BITS)
+                    {
+                        size_t count = vertices - j < BitMatrix::WORD_BITS ? vertices - j : BitMatrix::WORD_BITS;
+                        std::uint64_t word = 0;
+                        for (size_t b = 0; b < count; ++b)
+                        {
+                            word |= std::uint64_t(row[j + b] != 0) << b;
+                        }
+                        out[j / BitMatrix::WORD_BITS] = word;
+                    }
+                }
+                else
+                {
+                    for (size_t e = offsets[i]; e < offsets[i + 1]; ++e)
+                    {
+                        bits.set(i, columns[e]);
+                    }
+                }
+            }
+            return bits;
+        }
+
+        /// @brief Scans the edges for their smallest and largest weights.
+        WeightRange<W> findWeightRange() const
+        {
+            WeightRange<W> range;
+            bool first = true;
+            for (size_t i = 0; i < vertices; ++i)
+            {
+                const W *row = representation == Representation::Dense ? cells + i * stride : weights + offsets[i];
+                size_t count = representation == Representation::Dense ? vertices : offsets[i + 1] - offsets[i];
+                for (size_t j = 0; j < count; ++j)
+                {
+                    if (row[j] != 0)
+                    {
+                        range.smallest = first || row[j] < range.smallest ? row[j] : range.smallest;
+                        range.largest = first || row[j] > range.largest ? row[j] : range.largest;
+                        first = false;
+                    }
+                }
+            }
+            return range;
+        }
+
+        /// @brief The owning graph's cached transpose (every edge reversed), or null if the view has no owning graph.
+        std::shared_ptr<const BasicGraph<W>> transposed() const
+        {
+            return owner != nullptr ? owner->transposed() : nullptr;
+        }
+
+        /// @brief The smallest and largest edge weights: the owning graph's cached ones if there are any, otherwise
+        /// found now in O(n^2) (dense) or O(m) (sparse).
+        WeightRange<W> weightRange() const
+        {
+            return owner != nullptr ? owner->weightRange() : findWeightRange();
+        }
+
+        /// @brief The packed adjacency: the owning graph's cached copy if there is one, otherwise built now
+        /// in memory from resource.
+        std::shared_ptr<const BitMatrix> adjacencyBits(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const
+        {
+            if (owner != nullptr)
+            {
+                return owner->adjacencyBits();
+            }
+            return std::allocate_shared<BitMatrix>(std::pmr::polymorphic_allocator<BitMatrix>(resource), toBitMatrix(resource));
+        }
+    };
+} // namespace ariel
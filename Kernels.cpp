@@ -0,0 +1,332 @@
+#include "Kernels.hpp"
+#include <algorithm>
+
+using namespace std;
+
+// Compiles a kernel once per instruction set and dispatches on the running CPU
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define ARIEL_SIMD __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef ARIEL_SIMD
+#define ARIEL_SIMD
+#endif
+
+// The loops themselves, inlined into every version of every kernel so each is vectorized for its target
+#define ARIEL_INLINE inline __attribute__((always_inline))
+
+namespace
+{
+    template <typename W>
+    ARIEL_INLINE void addLoop(const W *__restrict a, const W *__restrict b, W *__restrict out, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = W(a[i] + b[i]);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void subtractLoop(const W *__restrict a, const W *__restrict b, W *__restrict out, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = W(a[i] - b[i]);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void addToLoop(W *__restrict values, const W *__restrict other, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = W(values[i] + other[i]);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void subtractFromLoop(W *__restrict values, const W *__restrict other, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = W(values[i] - other[i]);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void addScalarLoop(W *__restrict values, W num, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = W(values[i] + num);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void subtractScalarLoop(W *__restrict values, W num, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = W(values[i] - num);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void scaleLoop(W *__restrict values, W factor, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = W(values[i] * factor);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE void scaleLoop(const W *__restrict a, W factor, W *__restrict out, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = W(a[i] * factor);
+        }
+    }
+
+    template <typename W>
+    ARIEL_INLINE size_t countNonZeroLoop(const W *__restrict values, size_t count, size_t *__restrict inDegrees)
+    {
+        size_t nonZero = 0;
+        for (size_t j = 0; j < count; ++j)
+        {
+            size_t edge = values[j] != 0 ? 1 : 0;
+            nonZero += edge;
+            inDegrees[j] += edge;
+        }
+        return nonZero;
+    }
+
+    // Entries a counted scalar kernel takes at a time: small enough to be read twice from L1
+    constexpr size_t COUNTED_BLOCK = 1024;
+
+    // values += num (or -= num when Subtract), keeping the counts of non-zero values. A value can only gain
+    // or lose its edge if it is zero before or after, which is rare, so each block is first shifted while
+    // counting such values, and only blocks that have one pay for a second pass that updates inDegrees.
+    // That pass needs the values from before the shift: integers get them back exactly by shifting the
+    // other way (the arithmetic wraps), floating-point values are instead checked by a read-only pass first.
+    template <bool Subtract, typename W>
+    ARIEL_INLINE ptrdiff_t shiftScalarCountedLoop(W *__restrict values, W num, size_t count, size_t *__restrict inDegrees)
+    {
+        ptrdiff_t change = 0;
+        for (size_t first = 0; first < count; first += COUNTED_BLOCK)
+        {
+            size_t last = min(count, first + COUNTED_BLOCK);
+            size_t flips = 0;
+            if (is_integral<W>::value)
+            {
+                for (size_t j = first; j < last; ++j)
+                {
+                    W before = values[j];
+                    W after = Subtract ? W(before - num) : W(before + num);
+                    values[j] = after;
+                    flips += (before == 0) != (after == 0) ? 1 : 0;
+                }
+            }
+            else
+            {
+                for (size_t j = first; j < last; ++j)
+                {
+                    W after = Subtract ? W(values[j] - num) : W(values[j] + num);
+                    flips += (values[j] == 0) != (after == 0) ? 1 : 0;
+                }
+                if (flips == 0)
+                {
+                    for (size_t j = first; j < last; ++j)
+                    {
+                        values[j] = Subtract ? W(values[j] - num) : W(values[j] + num);
+                    }
+                }
+            }
+            if (flips == 0)
+            {
+                continue;
+            }
+            for (size_t j = first; j < last; ++j)
+            {
+                W before;
+                W after;
+                if (is_integral<W>::value)
+                {
+                    after = values[j];
+                    before = Subtract ? W(after + num) : W(after - num);
+                }
+                else
+                {
+                    before = values[j];
+                    after = Subtract ? W(before - num) : W(before + num);
+                    values[j] = after;
+                }
+                ptrdiff_t flip = ptrdiff_t(after != 0) - ptrdiff_t(before != 0);
+                inDegrees[j] = size_t(ptrdiff_t(inDegrees[j]) + flip);
+                change += flip;
+            }
+        }
+        return change;
+    }
+
+    ARIEL_INLINE void orIntoLoop(uint64_t *__restrict values, const uint64_t *__restrict other, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] |= other[i];
+        }
+    }
+
+    // Wrapping addition, so that the sums with max() that pathThrough discards are not undefined
+    ARIEL_INLINE int64_t wrappingAdd(int64_t a, int64_t b) { return int64_t(uint64_t(a) + uint64_t(b)); }
+    ARIEL_INLINE double wrappingAdd(double a, double b) { return a + b; }
+
+    // 1 if sum, the wrapped a + b, overflowed: a and b have the same sign and sum the other one
+    ARIEL_INLINE unsigned wrapped(int64_t a, int64_t b, int64_t sum) { return unsigned(((a ^ sum) & (b ^ sum)) < 0); }
+    ARIEL_INLINE unsigned wrapped(double, double, double) { return 0; }
+
+    // through + onward, or max() if onward is max(), clamped from below at lowest() / 4. When Checked,
+    // sets overflowed to 1 if the sum does not fit in A.
+    template <bool Checked, typename A>
+    ARIEL_INLINE A pathThrough(A through, A onward, unsigned &overflowed)
+    {
+        A sum = wrappingAdd(through, onward);
+        bool none = onward == numeric_limits<A>::max();
+        if (Checked)
+        {
+            overflowed |= wrapped(through, onward, sum) & unsigned(!none);
+        }
+        return none ? onward : max(sum, A(numeric_limits<A>::lowest() / 4));
+    }
+
+    template <bool Checked, typename A>
+    ARIEL_INLINE bool relaxThroughLoop(A *__restrict distances, A through, const A *__restrict onward, size_t count)
+    {
+        unsigned overflowed = 0;
+        for (size_t j = 0; j < count; ++j)
+        {
+            distances[j] = min(distances[j], pathThrough<Checked>(through, onward[j], overflowed));
+        }
+        return overflowed != 0;
+    }
+
+    template <bool Checked, typename A>
+    ARIEL_INLINE bool relaxThroughLoop(A *__restrict distances, A through, const A *__restrict onward,
+                                       size_t *__restrict next, size_t hop, size_t count)
+    {
+        unsigned overflowed = 0;
+        for (size_t j = 0; j < count; ++j)
+        {
+            A candidate = pathThrough<Checked>(through, onward[j], overflowed);
+            bool shorter = candidate < distances[j];
+            distances[j] = shorter ? candidate : distances[j];
+            next[j] = shorter ? hop : next[j];
+        }
+        return overflowed != 0;
+    }
+
+    // The sums of the tile are kept in registers for the whole depth, and added to c once
+    template <typename S>
+    ARIEL_INLINE void multiplyTileLoop(const typename S::Value *__restrict a, const typename S::Value *__restrict b,
+                                       typename S::Value *__restrict c, size_t stride, size_t depth)
+    {
+        using ariel::simd::TILE_COLUMNS;
+        using ariel::simd::TILE_ROWS;
+        using Value = typename S::Value;
+        Value sums[TILE_ROWS][TILE_COLUMNS];
+        for (size_t i = 0; i < TILE_ROWS; ++i)
+        {
+            for (size_t j = 0; j < TILE_COLUMNS; ++j)
+            {
+                sums[i][j] = S::zero();
+            }
+        }
+        for (size_t k = 0; k < depth; ++k)
+        {
+            for (size_t i = 0; i < TILE_ROWS; ++i)
+            {
+                Value left = a[k * TILE_ROWS + i];
+                for (size_t j = 0; j < TILE_COLUMNS; ++j)
+                {
+                    sums[i][j] = S::add(sums[i][j], S::multiply(left, b[k * TILE_COLUMNS + j]));
+                }
+            }
+        }
+        for (size_t i = 0; i < TILE_ROWS; ++i)
+        {
+            for (size_t j = 0; j < TILE_COLUMNS; ++j)
+            {
+                c[i * stride + j] = S::add(c[i * stride + j], sums[i][j]);
+            }
+        }
+    }
+} // namespace
+
+// The supported weight types
+#define ARIEL_DEFINE_KERNELS(W)                                                                                           \
+    ARIEL_SIMD void ariel::simd::add(const W *a, const W *b, W *out, size_t count) { addLoop(a, b, out, count); }           \
+    ARIEL_SIMD void ariel::simd::subtract(const W *a, const W *b, W *out, size_t count) { subtractLoop(a, b, out, count); } \
+    ARIEL_SIMD void ariel::simd::addTo(W *values, const W *other, size_t count) { addToLoop(values, other, count); }       \
+    ARIEL_SIMD void ariel::simd::subtractFrom(W *values, const W *other, size_t count) { subtractFromLoop(values, other, count); } \
+    ARIEL_SIMD void ariel::simd::addScalar(W *values, W num, size_t count) { addScalarLoop(values, num, count); }          \
+    ARIEL_SIMD void ariel::simd::subtractScalar(W *values, W num, size_t count) { subtractScalarLoop(values, num, count); } \
+    ARIEL_SIMD void ariel::simd::scale(W *values, W factor, size_t count) { scaleLoop(values, factor, count); }           \
+    ARIEL_SIMD void ariel::simd::scale(const W *a, W factor, W *out, size_t count) { scaleLoop(a, factor, out, count); }  \
+    ARIEL_SIMD size_t ariel::simd::countNonZero(const W *values, size_t count, size_t *inDegrees) { return countNonZeroLoop(values, count, inDegrees); } \
+    ARIEL_SIMD ptrdiff_t ariel::simd::addScalarCounted(W *values, W num, size_t count, size_t *inDegrees)                 \
+    {                                                                                                                     \
+        return shiftScalarCountedLoop<false>(values, num, count, inDegrees);                                              \
+    }                                                                                                                     \
+    ARIEL_SIMD ptrdiff_t ariel::simd::subtractScalarCounted(W *values, W num, size_t count, size_t *inDegrees)            \
+    {                                                                                                                     \
+        return shiftScalarCountedLoop<true>(values, num, count, inDegrees);                                               \
+    }
+
+ARIEL_DEFINE_KERNELS(int8_t)
+ARIEL_DEFINE_KERNELS(int16_t)
+ARIEL_DEFINE_KERNELS(int32_t)
+ARIEL_DEFINE_KERNELS(int64_t)
+ARIEL_DEFINE_KERNELS(float)
+ARIEL_DEFINE_KERNELS(double)
+
+ARIEL_SIMD void ariel::simd::orInto(uint64_t *values, const uint64_t *other, size_t count)
+{
+    orIntoLoop(values, other, count);
+}
+
+#define ARIEL_DEFINE_RELAX(A)                                                                                      \
+    ARIEL_SIMD void ariel::simd::relaxThrough(A *distances, A through, const A *onward, size_t count)                 \
+    {                                                                                                                  \
+        relaxThroughLoop<false>(distances, through, onward, count);                                                    \
+    }                                                                                                                  \
+    ARIEL_SIMD void ariel::simd::relaxThrough(A *distances, A through, const A *onward, size_t *next, size_t hop, size_t count) \
+    {                                                                                                                  \
+        relaxThroughLoop<false>(distances, through, onward, next, hop, count);                                         \
+    }                                                                                                                  \
+    ARIEL_SIMD bool ariel::simd::relaxThroughChecked(A *distances, A through, const A *onward, size_t count)          \
+    {                                                                                                                  \
+        return relaxThroughLoop<true>(distances, through, onward, count);                                              \
+    }                                                                                                                  \
+    ARIEL_SIMD bool ariel::simd::relaxThroughChecked(A *distances, A through, const A *onward, size_t *next, size_t hop, \
+                                                     size_t count)                                                     \
+    {                                                                                                                  \
+        return relaxThroughLoop<true>(distances, through, onward, next, hop, count);                                   \
+    }
+
+ARIEL_DEFINE_RELAX(int64_t)
+ARIEL_DEFINE_RELAX(double)
+
+#define ARIEL_DEFINE_TILE(S)                                                                                \
+    ARIEL_SIMD void ariel::simd::multiplyTile(S, const S::Value *a, const S::Value *b, S::Value *c, size_t stride, \
+                                              size_t depth) { multiplyTileLoop<S>(a, b, c, stride, depth); }
+
+ARIEL_DEFINE_TILE(ariel::PlusTimes<int64_t>)
+ARIEL_DEFINE_TILE(ariel::PlusTimes<double>)
+ARIEL_DEFINE_TILE(ariel::MinPlus<int64_t>)
+ARIEL_DEFINE_TILE(ariel::MinPlus<double>)
+ARIEL_DEFINE_TILE(ariel::OrAnd<int64_t>)
+ARIEL_DEFINE_TILE(ariel::OrAnd<double>)
+ARIEL_DEFINE_TILE(ariel::MaxMin<int64_t>)
+ARIEL_DEFINE_TILE(ariel::MaxMin<double>)
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Semiring.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ariel
+{
+    /// @brief Elementwise kernels over contiguous arrays, used by the Graph operators.
+    /// Where the compiler supports function multiversioning (GCC and Clang on x86-64) every kernel is
+    /// compiled for AVX-512, AVX2 and the baseline target (SSE2), and the version matching the running
+    /// CPU is picked when the program is loaded; elsewhere it is a plain loop vectorized for the build
+    /// target. The arrays passed to one call must not overlap.
+    namespace simd
+    {
+#define ARIEL_DECLARE_KERNELS(W)                                                                       \
+    void add(const W *a, const W *b, W *out, std::size_t count);           /* out = a + b */          \
+    void subtract(const W *a, const W *b, W *out, std::size_t count);      /* out = a - b */          \
+    void addTo(W *values, const W *other, std::size_t count);              /* values += other */      \
+    void subtractFrom(W *values, const W *other, std::size_t count);       /* values -= other */      \
+    void addScalar(W *values, W num, std::size_t count);                   /* values += num */        \
+    void subtractScalar(W *values, W num, std::size_t count);              /* values -= num */        \
+    void scale(W *values, W factor, std::size_t count);                    /* values *= factor */     \
+    void scale(const W *a, W factor, W *out, std::size_t count);           /* out = a * factor */     \
+    /* Returns the number of non-zero values, and adds 1 to inDegrees[j] for every non-zero values[j] */ \
+    std::size_t countNonZero(const W *values, std::size_t count, std::size_t *inDegrees);                   \
+    /* values += num or values -= num; returns the number of values that became non-zero minus the number */ \
+    /* that became zero, and adds the same change for values[j] to inDegrees[j] */                            \
+    std::ptrdiff_t addScalarCounted(W *values, W num, std::size_t count, std::size_t *inDegrees);          \
+    std::ptrdiff_t subtractScalarCounted(W *values, W num, std::size_t count, std::size_t *inDegrees);
+
+        ARIEL_DECLARE_KERNELS(std::int8_t)
+        ARIEL_DECLARE_KERNELS(std::int16_t)
+        ARIEL_DECLARE_KERNELS(std::int32_t)
+        ARIEL_DECLARE_KERNELS(std::int64_t)
+        ARIEL_DECLARE_KERNELS(float)
+        ARIEL_DECLARE_KERNELS(double)
+
+#undef ARIEL_DECLARE_KERNELS
+
+        // values |= other, word by word: the union of two bit sets (BitMatrix rows)
+        void orInto(std::uint64_t *values, const std::uint64_t *other, std::size_t count);
+
+        /// @brief One Floyd-Warshall step for a run of a row: distances[j] = min(distances[j], through + onward[j]).
+        /// numeric_limits<A>::max() stands for no path (through must not be it), and sums are clamped at
+        /// lowest() / 4 so that distances driven down by negative cycles cannot overflow. The second form also
+        /// sets next[j] = hop wherever the distance improved. relaxThroughChecked also returns true if some sum
+        /// did not fit in A, for distances too large for the caller to rule that out.
+#define ARIEL_DECLARE_RELAX(A)                                                                                \
+    void relaxThrough(A *distances, A through, const A *onward, std::size_t count);                           \
+    void relaxThrough(A *distances, A through, const A *onward, std::size_t *next, std::size_t hop, std::size_t count); \
+    bool relaxThroughChecked(A *distances, A through, const A *onward, std::size_t count);                    \
+    bool relaxThroughChecked(A *distances, A through, const A *onward, std::size_t *next, std::size_t hop, std::size_t count);
+
+        ARIEL_DECLARE_RELAX(std::int64_t)
+        ARIEL_DECLARE_RELAX(double)
+
+#undef ARIEL_DECLARE_RELAX
+
+        // Shape of the block of the product that multiplyTile keeps in registers
+        constexpr std::size_t TILE_ROWS = 4;
+        constexpr std::size_t TILE_COLUMNS = 8;
+
+        /// @brief The inner kernel of the matrix product over semiring S: adds (in S) a packed
+        /// TILE_ROWS x depth panel a times a packed depth x TILE_COLUMNS panel b to the
+        /// TILE_ROWS x TILE_COLUMNS block of c whose rows are stride apart. Panels are stored k by k:
+        /// a[k * TILE_ROWS + i] and b[k * TILE_COLUMNS + j]. The semiring is passed as a tag, one
+        /// overload per semiring and value type.
+#define ARIEL_DECLARE_TILE(S) \
+    void multiplyTile(S, const S::Value *a, const S::Value *b, S::Value *c, std::size_t stride, std::size_t depth);
+
+        ARIEL_DECLARE_TILE(PlusTimes<std::int64_t>)
+        ARIEL_DECLARE_TILE(PlusTimes<double>)
+        ARIEL_DECLARE_TILE(MinPlus<std::int64_t>)
+        ARIEL_DECLARE_TILE(MinPlus<double>)
+        ARIEL_DECLARE_TILE(OrAnd<std::int64_t>)
+        ARIEL_DECLARE_TILE(OrAnd<double>)
+        ARIEL_DECLARE_TILE(MaxMin<std::int64_t>)
+        ARIEL_DECLARE_TILE(MaxMin<double>)
+
+#undef ARIEL_DECLARE_TILE
+    } // namespace simd
+} // namespace ariel
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ariel
+{
+    /// @brief Number of worker threads used by the parallel kernels.
+    inline std::size_t threadCount()
+    {
+        unsigned hardware = std::thread::hardware_concurrency();
+        return hardware == 0 ? 1 : hardware;
+    }
+
+    namespace detail
+    {
+        // threadCount() - 1 threads, started on first use and kept until the program exits, that run the
+        // slices of parallelFor together with the calling thread. The pool serves one parallelFor at a
+        // time: a call made while it is busy, from another thread or from inside a slice, runs on its
+        // own thread instead of waiting for it.
+        class WorkerPool
+        {
+        public:
+            static WorkerPool &instance()
+            {
+                static WorkerPool pool(threadCount() - 1);
+                return pool;
+            }
+
+            // True on the threads running a slice, where a nested parallelFor must not wait for the pool
+            static bool &insideSlice()
+            {
+                thread_local bool inside = false;
+                return inside;
+            }
+
+            // Runs task(0), ..., task(tasks - 1) on the workers and the calling thread, and returns true once all
+            // have finished, or returns false at once, running nothing, if the pool is serving another call
+            template <typename Task>
+            bool tryRun(std::size_t tasks, Task &task)
+            {
+                std::unique_lock<std::mutex> turn(running, std::try_to_lock);
+                if (!turn.owns_lock())
+                {
+                    return false;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    invoke = [](void *context, std::size_t index)
+                    { (*static_cast<Task *>(context))(index); };
+                    context = &task;
+                    total = tasks;
+                    next = 0;
+                    finished = 0;
+                    open = true;
+                    ++generation;
+                }
+                wake.notify_all();
+                work();
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this]()
+                          { return finished == total && busy == 0; });
+                open = false;
+                return true;
+            }
+
+        private:
+            std::mutex running; // held for a whole run; a thread that cannot take it runs its range alone
+            std::mutex mutex;   // guards everything below
+            std::condition_variable wake;
+            std::condition_variable done;
+            std::vector<std::thread> workers;
+            void (*invoke)(void *, std::size_t) = nullptr;
+            void *context = nullptr;
+            std::size_t total = 0;      // tasks of the current run
+            std::size_t next = 0;       // first task not yet taken
+            std::size_t finished = 0;   // tasks done
+            std::size_t busy = 0;       // workers that joined the current run and have not left it
+            std::size_t generation = 0; // runs started so far
+            bool open = false;          // a run is waiting for its tasks; workers may still join it
+            bool stopping = false;
+
+            explicit WorkerPool(std::size_t count)
+            {
+                for (std::size_t w = 0; w < count; ++w)
+                {
+                    workers.emplace_back([this]()
+                                         { serve(); });
+                }
+            }
+
+            ~WorkerPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                wake.notify_all();
+                for (std::thread &worker : workers)
+                {
+                    worker.join();
+                }
+            }
+
+            // Takes tasks of the current run until none is left
+            void work()
+            {
+                insideSlice() = true;
+                std::unique_lock<std::mutex> lock(mutex);
+                while (next < total)
+                {
+                    std::size_t index = next++;
+                    lock.unlock();
+                    invoke(context, index);
+                    lock.lock();
+                    ++finished;
+                }
+                insideSlice() = false;
+            }
+
+            void serve()
+            {
+                std::size_t seen = 0;
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    wake.wait(lock, [this, seen]()
+                              { return stopping || generation != seen; });
+                    if (stopping)
+                    {
+                        return;
+                    }
+                    seen = generation;
+                    if (!open)
+                    {
+                        continue; // woke after the run was over
+                    }
+                    ++busy;
+                    lock.unlock();
+                    work();
+                    lock.lock();
+                    --busy;
+                    if (finished == total && busy == 0)
+                    {
+                        done.notify_one();
+                    }
+                }
+            }
+        };
+    } // namespace detail
+
+    /// @brief Splits [first, last) into one contiguous slice per thread and runs body(begin, end) on each.
+    /// Slices are at least grain long; small ranges run on the calling thread. The slices run on a pool of
+    /// threads started by the first call and reused by every later one, together with the calling thread.
+    /// While the pool serves one call, a call from another thread, or from inside a slice, runs its whole
+    /// range as one slice on its own thread, so independent callers never wait for each other. The first
+    /// exception thrown by a slice is rethrown once every slice has finished.
+    template <typename Body>
+    void parallelFor(std::size_t first, std::size_t last, Body body, std::size_t grain = 1)
+    {
+        std::size_t count = last > first ? last - first : 0;
+        std::size_t workers = std::min(threadCount(), (count + grain - 1) / std::max<std::size_t>(grain, 1));
+        if (workers <= 1 || detail::WorkerPool::insideSlice())
+        {
+            if (count > 0)
+            {
+                body(first, last);
+            }
+            return;
+        }
+
+        std::size_t slice = (count + workers - 1) / workers;
+        workers = (count + slice - 1) / slice;
+        std::vector<std::exception_ptr> errors(workers);
+        auto task = [&](std::size_t w)
+        {
+            std::size_t begin = first + w * slice;
+            std::size_t end = std::min(last, begin + slice);
+            try
+            {
+                body(begin, end);
+            }
+            catch (...)
+            {
+                errors[w] = std::current_exception();
+            }
+        };
+        if (!detail::WorkerPool::instance().tryRun(workers, task))
+        {
+            body(first, last);
+            return;
+        }
+        for (const std::exception_ptr &error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+} // namespace ariel
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ariel
+{
+    /// @brief Converts a value computed in a wider type back to the weight type W.
+    /// Throws if an integral weight type cannot hold it, rather than letting it wrap around.
+    template <typename W, typename V>
+    W narrowWeight(V value)
+    {
+        if constexpr (std::is_integral<W>::value)
+        {
+            if (value < std::numeric_limits<W>::lowest() || value > std::numeric_limits<W>::max())
+            {
+                throw std::runtime_error("The product of the graphs overflows their weight type");
+            }
+        }
+        return W(value);
+    }
+
+    // The semirings a matrix product can be computed over (see BasicGraph::multiply). Each is a
+    // template over the type V that products are combined in, WeightTraits<W>::Accumulator for
+    // graphs with weights W, and provides:
+    //   Value                 the type of its elements
+    //   zero()                the sum of no products, which also stands for a missing edge
+    //   one()                 the product of no factors, the value of a path of no edges
+    //   add(a, b), multiply(a, b)
+    //   idempotent            true if add(a, a) == a, so that summing a path twice changes nothing
+    //   lift<W>(weight)       a graph weight as an element (a zero weight, no edge, as zero())
+    //   lower<W>(value)       an element as a graph weight (zero() as 0, no edge)
+    // Every operation is a static inline function, so the product kernels are compiled with the
+    // semiring's operations inlined into their inner loop.
+
+    /// @brief (+, x): the ordinary matrix product, the sum of the weights of every two-edge path.
+    template <typename V>
+    struct PlusTimes
+    {
+        using Value = V;
+        static constexpr V zero() { return V(0); }
+        static constexpr V one() { return V(1); }
+        static constexpr bool idempotent = false;
+        static V add(V a, V b) { return a + b; }
+        static V multiply(V a, V b) { return a * b; }
+        template <typename W>
+        static V lift(W weight) { return V(weight); }
+        template <typename W>
+        static W lower(V value) { return narrowWeight<W>(value); }
+    };
+
+    /// @brief (min, +): the length of the shortest path of two edges. A product of min-plus
+    /// products is a shortest path product; an entry of 0 means there is no such path.
+    template <typename V>
+    struct MinPlus
+    {
+        using Value = V;
+        static constexpr V zero() { return std::numeric_limits<V>::max(); }
+        static constexpr V one() { return V(0); }
+        static constexpr bool idempotent = true;
+        static V add(V a, V b) { return std::min(a, b); }
+        static V multiply(V a, V b) { return a == zero() || b == zero() ? zero() : a + b; }
+        template <typename W>
+        static V lift(W weight) { return weight == 0 ? zero() : V(weight); }
+        template <typename W>
+        static W lower(V value) { return value == zero() ? W(0) : narrowWeight<W>(value); }
+    };
+
+    /// @brief (or, and): whether there is a path of two edges. Entries are 1 or 0.
+    template <typename V>
+    struct OrAnd
+    {
+        using Value = std::uint8_t;
+        static constexpr Value zero() { return 0; }
+        static constexpr Value one() { return 1; }
+        static constexpr bool idempotent = true;
+        static Value add(Value a, Value b) { return Value(a | b); }
+        static Value multiply(Value a, Value b) { return Value(a & b); }
+        template <typename W>
+        static Value lift(W weight) { return weight != 0 ? 1 : 0; }
+        template <typename W>
+        static W lower(Value value) { return W(value); }
+    };
+
+    /// @brief (max, min): the largest bottleneck (smallest edge weight) of a path of two edges,
+    /// e.g. the widest capacity between two vertices through one intermediate vertex.
+    template <typename V>
+    struct MaxMin
+    {
+        using Value = V;
+        static constexpr V zero() { return std::numeric_limits<V>::lowest(); }
+        static constexpr V one() { return std::numeric_limits<V>::max(); }
+        static constexpr bool idempotent = true;
+        static V add(V a, V b) { return std::max(a, b); }
+        static V multiply(V a, V b) { return std::min(a, b); }
+        template <typename W>
+        static V lift(W weight) { return weight == 0 ? zero() : V(weight); }
+        // one(), the unlimited bottleneck of a path of no edges, is not a weight either
+        template <typename W>
+        static W lower(V value) { return value == zero() || value == one() ? W(0) : W(value); }
+    };
+} // namespace ariel
@@ -1,5 +1,12 @@
 #include "doctest.h"
 #include "Graph.hpp"
+#include "Algorithms.hpp"
+#include "Parallel.hpp"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 using namespace ariel;
@@ -14,6 +21,10 @@ TEST_CASE("Test graph addition")
     Graph expected;
     expected.loadGraph({{6, 8}, {10, 12}});
     CHECK(result == expected);
+    g1 += g2;
+    CHECK(g1 == expected);
+    g1 += g1;
+    CHECK(g1.getWeight(1, 1) == 24);
 }
 
 TEST_CASE("Test graph subtraction")
@@ -26,6 +37,9 @@ TEST_CASE("Test graph subtraction")
     Graph expected;
     expected.loadGraph({{4, 4}, {4, 4}});
     CHECK(result == expected);
+    CHECK(g1.getWeight(0, 0) == 5); // the operands are not modified
+    g1 -= g2;
+    CHECK(g1 == expected);
 }
 
 TEST_CASE("Test scalar addition")
@@ -175,6 +189,9 @@ TEST_CASE("Test scalar multiplication")
     Graph expected;
     expected.loadGraph({{2, 4}, {6, 8}});
     CHECK(result == expected);
+    CHECK(g.getWeight(1, 1) == 4); // the operand is not modified
+    g *= 2;
+    CHECK(g == expected);
 }
 
 TEST_CASE("Test graph multiplication")
@@ -214,3 +231,1273 @@ TEST_CASE("Test unary minus operator")
     expected.loadGraph({{-1, -2}, {3, -4}});
     CHECK(g == expected);
 }
+
+TEST_CASE("Test row view")
+{
+    Graph g;
+    g.loadGraph({{1, 2, 0}, {3, 4, 5}, {0, 0, 6}});
+    RowView row = g.row(1);
+    CHECK(row.size() == 3);
+    CHECK(row[0] == 3);
+    CHECK(row[2] == 5);
+    CHECK(g.row(2)[2] == 6);
+}
+
+TEST_CASE("Test ragged adjacency matrix")
+{
+    Graph g;
+    CHECK_THROWS(g.loadGraph({{1, 2}, {3}}));
+}
+
+TEST_CASE("Test sparse representation selection")
+{
+    vector<vector<int>> matrix(20, vector<int>(20, 0));
+    matrix[0][5] = 3;
+    matrix[7][2] = -1;
+    Graph g;
+    g.loadGraph(matrix);
+    CHECK(g.getRepresentation() == Representation::Sparse);
+    CHECK(g.getEdges() == 2);
+    CHECK(g.getWeight(0, 5) == 3);
+    CHECK(g.getWeight(7, 2) == -1);
+    CHECK(g.getWeight(5, 0) == 0);
+    g += 1;
+    CHECK(g.getRepresentation() == Representation::Dense);
+    CHECK(g.getWeight(5, 0) == 1);
+}
+
+TEST_CASE("Test sparse and dense graphs agree")
+{
+    vector<vector<int>> a = {{0, 1, 0}, {0, 0, 2}, {3, 0, 0}};
+    vector<vector<int>> b = {{0, 0, 4}, {0, 0, -2}, {0, 5, 0}};
+    Graph dense;
+    dense.loadGraph(a, Representation::Dense);
+    Graph sparse;
+    sparse.loadGraph(a, Representation::Sparse);
+    CHECK(dense == sparse);
+    Graph other;
+    other.loadGraph(b, Representation::Sparse);
+    Graph expected;
+    expected.loadGraph({{0, 1, 4}, {0, 0, 0}, {3, 5, 0}});
+    CHECK(sparse + other == expected);
+    CHECK(dense + other == expected);
+    CHECK(sparse * other == dense * other);
+}
+
+TEST_CASE("Test bit-packed adjacency")
+{
+    vector<vector<int>> matrix(70, vector<int>(70, 1));
+    matrix[3][66] = 0;
+    Graph g;
+    g.loadGraph(matrix);
+    auto bits = g.adjacencyBits();
+    CHECK(bits->size() == 70);
+    CHECK(bits->wordsPerRow() == 2);
+    CHECK(bits->test(3, 65));
+    CHECK_FALSE(bits->test(3, 66));
+    CHECK(g.adjacencyBits() == bits);
+    g -= 1;
+    CHECK_FALSE(g.adjacencyBits()->test(3, 65));
+}
+
+TEST_CASE("Test bipartite groups are printed after each search")
+{
+    // Two components: the groups so far are printed once per search, dense or sparse
+    vector<vector<int>> matrix(40, vector<int>(40, 0));
+    matrix[0][1] = matrix[1][0] = 1;
+    matrix[2][3] = matrix[3][2] = 1;
+    for (Representation storage : {Representation::Dense, Representation::Sparse})
+    {
+        Graph g;
+        g.loadGraph(matrix, storage);
+        ostringstream printed;
+        streambuf *previous = cout.rdbuf(printed.rdbuf());
+        bool bipartite = Algorithms::isBipartite(g);
+        cout.rdbuf(previous);
+        CHECK(bipartite);
+        string text = printed.str();
+        CHECK(text.rfind("Graph is Bipartite! These are the possible groups:\nGroup 1: 0 \nGroup 2: 1 2 3 4 ", 0) == 0);
+        CHECK(text.find("Group 1: 0 2 \nGroup 2: 1 3 4 ") != string::npos);
+        CHECK(count(text.begin(), text.end(), '\n') == 1 + 2 * 38);
+    }
+}
+
+TEST_CASE("Test edge and degree counters")
+{
+    Graph g;
+    g.loadGraph({{0, 1, 2}, {0, 0, 3}, {-1, 0, 0}});
+    CHECK(g.getEdges() == 4);
+    CHECK(g.getOutDegree(0) == 2);
+    CHECK(g.getInDegree(2) == 2);
+    CHECK(g.getInDegree(1) == 1);
+    g += 1;
+    CHECK(g.getEdges() == 8);
+    CHECK(g.getOutDegree(2) == 2);
+    CHECK(g.getInDegree(0) == 2);
+    Graph h;
+    h.loadGraph({{1, 2, 3}, {1, 1, 4}, {0, 1, 1}});
+    Graph difference = g - h;
+    CHECK(difference.getEdges() == 0);
+    CHECK(g.getEdges() == 8);
+    g -= h;
+    CHECK(g.getEdges() == 0);
+    CHECK(g.getOutDegree(1) == 0);
+}
+
+TEST_CASE("Test narrow and floating-point weight types")
+{
+    BasicGraph<int8_t> small;
+    small.loadGraph({{0, 100}, {-100, 0}});
+    CHECK(sizeof(small.getWeight(0, 1)) == 1);
+    small += 1;
+    CHECK(small.getWeight(1, 0) == -99);
+    CHECK(small.getEdges() == 4);
+
+    BasicGraph<double> costs;
+    costs.loadGraph({{0, 0.5, 4.0}, {0, 0, 0.25}, {0, 0, 0}});
+    CHECK(Algorithms::shortestPath(costs, 0, 2) == vector<size_t>{0, 1, 2});
+}
+
+TEST_CASE("Test shortest path distances do not overflow")
+{
+    Graph g;
+    g.loadGraph({{0, 2000000000, 2100000000}, {0, 0, 2000000000}, {0, 0, 0}});
+    CHECK(Algorithms::shortestPath(g, 0, 2) == vector<size_t>{0, 2});
+}
+
+TEST_CASE("Test loading a moved matrix")
+{
+    vector<vector<int>> matrix = {{0, 1}, {1, 0}};
+    Graph g;
+    g.loadGraph(std::move(matrix));
+    Graph expected;
+    expected.loadGraph({{0, 1}, {1, 0}});
+    CHECK(g == expected);
+    CHECK(matrix.empty());
+}
+
+TEST_CASE("Test adopting a caller buffer")
+{
+    int released = 0;
+    int *cells = new int[4]{0, 2, 3, 0};
+    {
+        Graph g;
+        g.adoptGraph(cells, 2, [&released](int *data)
+                     { delete[] data; released++; });
+        CHECK(g.getEdges() == 2);
+        CHECK(g.row(1).data() == cells + 2);
+        Graph copy = g;
+        CHECK(copy.row(0).data() == cells);
+        copy += 1;
+        CHECK(copy.row(0).data() != cells);
+        CHECK(g.getWeight(0, 1) == 2);
+        CHECK(released == 0);
+    }
+    CHECK(released == 1);
+
+    vector<int> flat = {1, 0, 0, 1};
+    const int *storage = flat.data();
+    Graph h;
+    h.adoptGraph(std::move(flat), 2);
+    CHECK(h.row(0).data() == storage);
+    CHECK(h.getEdges() == 2);
+}
+
+TEST_CASE("Test algorithms on views over external memory")
+{
+    // The top-left 3 x 3 block of a 4 x 4 matrix: the path 0 -> 1 -> 2
+    int block[] = {0, 1, 0, 9,
+                   0, 0, 1, 9,
+                   0, 0, 0, 9,
+                   9, 9, 9, 9};
+    GraphView<int> path(block, 3, 4);
+    CHECK(Algorithms::isConnected(path));
+    CHECK_FALSE(Algorithms::isContainsCycle(path));
+    CHECK(Algorithms::shortestPath(path, 0, 2) == vector<size_t>{0, 1, 2});
+
+    // The same path as CSR arrays, plus the edge 2 -> 0 closing a cycle
+    size_t offsets[] = {0, 1, 2, 3};
+    size_t columns[] = {1, 2, 0};
+    int weights[] = {1, 1, -5};
+    GraphView<int> cycle(offsets, columns, weights, 3);
+    CHECK(Algorithms::isContainsCycle(cycle));
+    CHECK(Algorithms::negativeCycle(cycle));
+}
+
+TEST_CASE("Test saving and mapping graph files")
+{
+    Graph dense;
+    dense.loadGraph({{0, 3, 0}, {1, 0, 2}, {0, 7, 5}});
+    dense.save("test_dense.graph");
+    Graph mapped;
+    mapped.mapFile("test_dense.graph");
+    CHECK(mapped == dense);
+    CHECK(mapped.getEdges() == 5);
+    CHECK(mapped.getInDegree(1) == 2);
+    mapped += 1;
+    Graph reloaded;
+    reloaded.mapFile("test_dense.graph");
+    CHECK(reloaded == dense);
+
+    vector<vector<double>> matrix(30, vector<double>(30, 0));
+    matrix[4][9] = 0.5;
+    BasicGraph<double> sparse;
+    sparse.loadGraph(matrix);
+    sparse.save("test_sparse.graph");
+    BasicGraph<double> mappedSparse;
+    mappedSparse.mapFile("test_sparse.graph");
+    CHECK(mappedSparse.getRepresentation() == Representation::Sparse);
+    CHECK(mappedSparse == sparse);
+    CHECK_THROWS(mapped.mapFile("test_sparse.graph"));
+
+    // Corrupt copies of the sparse file: 64-byte header, offsets at 64, columns at 320, out-degrees at 448,
+    // in-degrees at 704. Each must be rejected and leave the graph as it was; the header and the ends of the
+    // offsets are always checked, the arrays themselves only when validating.
+    string bytes;
+    {
+        ifstream file("test_sparse.graph", ios::binary);
+        bytes.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+    vector<pair<size_t, uint64_t>> headerCorruptions = {{24, uint64_t(1) << 62}, // vertices: (n + 1) * 8 overflows
+                                                        {32, uint64_t(1) << 61}, // edges: edges * 8 overflows
+                                                        {32, 2},                 // more edges than the offsets end at
+                                                        {64, 1}};                // offsets do not start at 0
+    vector<pair<size_t, uint64_t>> arrayCorruptions = {{64 + 2 * 8, 1},   // offsets not monotone
+                                                       {320, 30},         // column out of range
+                                                       {448 + 4 * 8, 0},  // out-degree does not match
+                                                       {704 + 9 * 8, 2}}; // in-degree does not match
+    auto corrupt = [&](size_t offset, uint64_t value)
+    {
+        string copy = bytes;
+        memcpy(&copy[offset], &value, sizeof(value));
+        ofstream("test_corrupt.graph", ios::binary) << copy;
+    };
+    for (auto [offset, value] : headerCorruptions)
+    {
+        corrupt(offset, value);
+        CHECK_THROWS(mappedSparse.mapFile("test_corrupt.graph"));
+    }
+    for (auto [offset, value] : arrayCorruptions)
+    {
+        corrupt(offset, value);
+        CHECK_THROWS(mappedSparse.mapFile("test_corrupt.graph", true));
+    }
+    ofstream("test_corrupt.graph", ios::binary) << bytes.substr(0, 700);
+    CHECK_THROWS(mappedSparse.mapFile("test_corrupt.graph"));
+    CHECK(mappedSparse == sparse);
+    mappedSparse.mapFile("test_sparse.graph", true);
+    CHECK(mappedSparse == sparse);
+    remove("test_dense.graph");
+    remove("test_sparse.graph");
+    remove("test_corrupt.graph");
+}
+
+TEST_CASE("Test loading edge lists and Matrix Market files")
+{
+    {
+        ofstream file("test_edges.txt");
+        file << "# source target weight\n0 1 4\n1 2\n\n2 0 -3\n0 1 1\n";
+    }
+    Graph edges;
+    LoadStats stats = edges.loadEdgeList("test_edges.txt");
+    CHECK(stats.rows == 4);
+    CHECK(stats.bytes > 0);
+    CHECK(edges.getVertices() == 3);
+    CHECK(edges.getEdges() == 3);
+    CHECK(edges.getWeight(0, 1) == 5);
+    CHECK(edges.getWeight(1, 2) == 1);
+    CHECK(edges.getWeight(2, 0) == -3);
+    CHECK(edges.getInDegree(0) == 1);
+    {
+        ofstream file("test_unterminated.txt");
+        file << "0 1 4\n1 2 2"; // no newline after the last line
+    }
+    Graph unterminated;
+    CHECK(unterminated.loadEdgeList("test_unterminated.txt").rows == 2);
+    CHECK(unterminated.getWeight(1, 2) == 2);
+    remove("test_unterminated.txt");
+
+    {
+        ofstream file("test_matrix.mtx");
+        file << "%%MatrixMarket matrix coordinate real symmetric\n% a comment\n3 3 2\n2 1 1.5\n3 3 2\n";
+    }
+    BasicGraph<double> symmetric;
+    stats = symmetric.loadMatrixMarket("test_matrix.mtx");
+    CHECK(stats.rows == 2); // lines, not the 3 entries after mirroring
+    CHECK(symmetric.getEdges() == 3);
+    CHECK(symmetric.getWeight(0, 1) == 1.5);
+    CHECK(symmetric.getWeight(1, 0) == 1.5);
+    CHECK(symmetric.getWeight(2, 2) == 2);
+
+    {
+        ofstream file("test_matrix.mtx");
+        file << "%%MatrixMarket matrix coordinate integer general\n2 2 1\n1 x 3\n";
+    }
+    CHECK_THROWS(edges.loadMatrixMarket("test_matrix.mtx"));
+    {
+        ofstream file("test_matrix.mtx");
+        file << "%%MatrixMarket matrix coordinate integer general\n3 3 3\n1 2 3\n2 3 4\n";
+    }
+    CHECK_THROWS(edges.loadMatrixMarket("test_matrix.mtx")); // truncated: 2 of 3 entries
+    CHECK(edges.getEdges() == 3);
+    remove("test_edges.txt");
+    remove("test_matrix.mtx");
+}
+
+TEST_CASE("Test graphs and algorithms running out of an arena")
+{
+    static char storage[1 << 16];
+    pmr::monotonic_buffer_resource arena(storage, sizeof(storage), pmr::null_memory_resource());
+    // Anything that still allocated from the default resource would throw bad_alloc
+    pmr::memory_resource *previous = pmr::set_default_resource(pmr::null_memory_resource());
+
+    Graph g1(&arena);
+    g1.loadGraph({{0, 1, 0}, {1, 0, 1}, {0, 1, 0}});
+    Graph g2(&arena);
+    g2.loadGraph({{0, 2, 1}, {2, 0, 0}, {1, 0, 0}});
+    Graph sum = g1 + g2;
+    Graph product = g1 * g2;
+    CHECK(sum.getResource() == &arena);
+    CHECK(product.getResource() == &arena);
+    CHECK(sum.getWeight(0, 1) == 3);
+    CHECK(Algorithms::isConnected(sum, &arena));
+    CHECK(Algorithms::isContainsCycle(sum, &arena));
+    CHECK(Algorithms::isBipartite(g1, &arena));
+    CHECK_FALSE(Algorithms::negativeCycle(g2, &arena));
+    CHECK(Algorithms::shortestPath(g1, 0, 2, &arena) == vector<size_t>{0, 1, 2});
+
+    pmr::set_default_resource(previous);
+    Graph copy(sum, pmr::get_default_resource());
+    CHECK(copy.getResource() == pmr::get_default_resource());
+    CHECK(copy == sum);
+}
+
+TEST_CASE("Test copies share the matrix until one is modified")
+{
+    Graph original;
+    original.loadGraph({{0, 1, 2}, {3, 0, 4}, {5, 6, 0}});
+    Graph copy = original;
+    CHECK(copy.row(1).data() == original.row(1).data());
+
+    copy += 1;
+    CHECK(copy.row(1).data() != original.row(1).data());
+    CHECK(original.getWeight(0, 1) == 1);
+    CHECK(original.getEdges() == 6);
+    CHECK(copy.getWeight(0, 1) == 2);
+    CHECK(copy.getEdges() == 9);
+
+    Graph snapshot = original;
+    original.loadGraph({{0, 7}, {7, 0}});
+    CHECK(snapshot.getVertices() == 3);
+    CHECK(snapshot.getWeight(2, 1) == 6);
+    Graph scaled = snapshot;
+    -scaled;
+    CHECK(snapshot.getWeight(2, 1) == 6);
+    CHECK(scaled.getWeight(2, 1) == -6);
+
+    // Copies share the caches built so far, and copying while another thread builds them is safe
+    auto bits = snapshot.adjacencyBits();
+    CHECK(Graph(snapshot).adjacencyBits() == bits);
+    Graph moved = Graph(snapshot);
+    CHECK(moved.adjacencyBits() == bits);
+    Graph shared;
+    shared.loadGraph(vector<vector<int>>(200, vector<int>(200, 1)));
+    thread reader([&]
+                  { shared.adjacencyBits(); shared.weightRange(); shared.transposed(); });
+    bool consistent = true;
+    for (int i = 0; i < 100; ++i)
+    {
+        Graph copy = shared;
+        auto copyBits = copy.adjacencyBits();
+        consistent = consistent && copyBits->test(199, 0) && copy.weightRange().largest == 1;
+    }
+    reader.join();
+    CHECK(consistent);
+}
+
+// Counts the allocations of at least a given size made through it
+class LargeAllocationCounter : public pmr::memory_resource
+{
+public:
+    explicit LargeAllocationCounter(size_t threshold) : threshold(threshold) {}
+    size_t count = 0;
+
+private:
+    size_t threshold;
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        count += bytes >= threshold ? 1 : 0;
+        return pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override
+    {
+        pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+    bool do_is_equal(const pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+TEST_CASE("Test chains of elementwise operators are evaluated in one pass")
+{
+    LargeAllocationCounter counter(16 * 16 * sizeof(int));
+    vector<vector<int>> matrix(16, vector<int>(16, 1));
+    Graph g1(&counter), g2(&counter), g3(&counter);
+    g1.loadGraph(matrix);
+    g2.loadGraph(matrix);
+    matrix[3][4] = 5;
+    g3.loadGraph(matrix);
+    counter.count = 0;
+    Graph result = g1 + g2 - g3 * 2 + g1;
+    CHECK(counter.count == 1);
+    CHECK(result.getWeight(0, 0) == 1);
+    CHECK(result.getWeight(3, 4) == -7);
+    CHECK(g3.getWeight(3, 4) == 5); // no operand is modified
+    counter.count = 0;
+    result = g1 - (g2 - g3 * 3);
+    CHECK(counter.count == 1);
+    CHECK(result.getWeight(3, 4) == 15);
+
+    vector<vector<double>> sparseMatrix(40, vector<double>(40, 0));
+    sparseMatrix[1][2] = 1.5;
+    sparseMatrix[7][3] = 2;
+    BasicGraph<double> a;
+    a.loadGraph(sparseMatrix);
+    sparseMatrix[7][3] = 0;
+    sparseMatrix[9][9] = 4;
+    BasicGraph<double> b;
+    b.loadGraph(sparseMatrix);
+    BasicGraph<double> sparseResult = (a + b) * 2 - b;
+    CHECK(sparseResult.getRepresentation() == Representation::Sparse);
+    CHECK(sparseResult.getEdges() == 3);
+    CHECK(sparseResult.getWeight(1, 2) == 4.5);
+    CHECK(sparseResult.getWeight(7, 3) == 4);
+    CHECK(sparseResult.getWeight(9, 9) == 4);
+    CHECK(BasicGraph<double>(a + b - a - b).getEdges() == 0);
+    BasicGraph<double> small;
+    small.loadGraph({{0, 1}, {1, 0}});
+    CHECK_THROWS(a + b + small);
+
+    // A matrix product evaluates an expression operand first
+    BasicGraph<double> sum = a + b;
+    CHECK((a + b) * b == sum * b);
+    CHECK(b * (a + b) == b * sum);
+    CHECK((a + b) * (a - b) == sum * BasicGraph<double>(a - b));
+    CHECK(multiply<MinPlus>(a + b, b) == multiply<MinPlus>(sum, b));
+    CHECK(multiply<MinPlus>(b, a + b) == multiply<MinPlus>(b, sum));
+    CHECK(multiply<MinPlus>(a + b, a + b) == multiply<MinPlus>(sum, sum));
+}
+
+TEST_CASE("Test SIMD kernels on lengths that are not a multiple of the vector width")
+{
+    vector<int8_t> a(67), b(67), out(67);
+    for (size_t k = 0; k < a.size(); ++k)
+    {
+        a[k] = int8_t(k % 5);
+        b[k] = int8_t(k % 3);
+    }
+    simd::subtract(a.data(), b.data(), out.data(), out.size());
+    CHECK(out[66] == 1 - 0);
+    CHECK(out[65] == 0 - 2);
+    size_t inDegrees[67] = {};
+    size_t nonZero = simd::countNonZero(out.data(), out.size(), inDegrees);
+    CHECK(nonZero == size_t(count_if(out.begin(), out.end(), [](int8_t value)
+                                     { return value != 0; })));
+    CHECK(inDegrees[65] == 1);
+    CHECK(inDegrees[0] == 0);
+
+    vector<vector<float>> matrix(19, vector<float>(19, 0.5F));
+    matrix[18][18] = 0;
+    BasicGraph<float> g;
+    g.loadGraph(matrix);
+    g *= 4.0F;
+    CHECK(g.getWeight(18, 17) == 2.0F);
+    g -= 2.0F;
+    CHECK(g.getEdges() == 1);
+    CHECK(g.getWeight(18, 18) == -2.0F);
+    g -= g;
+    CHECK(g.getEdges() == 0);
+}
+
+TEST_CASE("Test blocked matrix multiplication")
+{
+    // Sizes that are not multiples of the tile and block sizes, compared with the textbook triple loop
+    for (size_t n : vector<size_t>{1, 3, 67, 301})
+    {
+        vector<vector<int>> a(n, vector<int>(n)), b(n, vector<int>(n));
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                a[i][j] = int((i * 7 + j * 3) % 11) - 5;
+                b[i][j] = (i + 2 * j) % 5 == 0 ? int(j % 7) : 0;
+            }
+        }
+        Graph g1, g2;
+        g1.loadGraph(a);
+        g2.loadGraph(b);
+        Graph product = g1 * g2;
+        size_t edges = 0;
+        bool same = true;
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                long sum = 0;
+                for (size_t k = 0; k < n; ++k)
+                {
+                    sum += long(a[i][k]) * b[k][j];
+                }
+                same = same && product.getWeight(i, j) == sum;
+                edges += sum != 0 ? 1 : 0;
+            }
+        }
+        CHECK(same);
+        CHECK(product.getEdges() == edges);
+    }
+
+    BasicGraph<int8_t> big;
+    big.loadGraph({{100, 100}, {100, 100}});
+    CHECK_THROWS(big * big);
+}
+
+TEST_CASE("Test sparse matrix multiplication")
+{
+    // A ring with chords: every product of sparse graphs must match the dense product
+    size_t n = 600;
+    vector<vector<int>> a(n, vector<int>(n, 0)), b(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        a[i][(i + 1) % n] = 2;
+        a[i][(i * 7) % n] = -1;
+        b[i][(i + 3) % n] = 1;
+        b[i][(i * 5 + 2) % n] = 3;
+    }
+    Graph sparse1, sparse2, dense1, dense2;
+    sparse1.loadGraph(a);
+    sparse2.loadGraph(b);
+    dense1.loadGraph(a, Representation::Dense);
+    dense2.loadGraph(b, Representation::Dense);
+    REQUIRE(sparse1.getRepresentation() == Representation::Sparse);
+    Graph product = sparse1 * sparse2;
+    Graph expected = dense1 * dense2;
+    CHECK(product.getRepresentation() == Representation::Sparse);
+    CHECK(product == expected);
+    CHECK(product.getEdges() == expected.getEdges());
+    bool sameDegrees = true;
+    for (size_t v = 0; v < n; ++v)
+    {
+        sameDegrees = sameDegrees && product.getOutDegree(v) == expected.getOutDegree(v) &&
+                      product.getInDegree(v) == expected.getInDegree(v);
+    }
+    CHECK(sameDegrees);
+    CHECK(sparse1 * dense2 == expected);
+
+    // Rows that may touch many columns are summed in a dense array instead of a hash table
+    vector<vector<int>> small(40, vector<int>(40, 0));
+    for (size_t i = 0; i < 40; ++i)
+    {
+        small[i][(i + 1) % 40] = 1;
+        small[i][(i + 5) % 40] = 2;
+        small[i][(i * 3) % 40] = -3;
+    }
+    Graph smallSparse, smallDense;
+    smallSparse.loadGraph(small, Representation::Sparse);
+    smallDense.loadGraph(small, Representation::Dense);
+    CHECK(smallSparse * smallSparse == smallDense * smallDense);
+}
+
+// The product of a and b over semiring S by definition, with 0 standing for a missing edge
+template <template <typename> class Semiring>
+vector<vector<int>> naiveProduct(const vector<vector<int>> &a, const vector<vector<int>> &b)
+{
+    using S = Semiring<int64_t>;
+    size_t n = a.size();
+    vector<vector<int>> product(n, vector<int>(n));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            typename S::Value sum = S::zero();
+            for (size_t k = 0; k < n; ++k)
+            {
+                sum = S::add(sum, S::multiply(S::lift(a[i][k]), S::lift(b[k][j])));
+            }
+            product[i][j] = S::template lower<int>(sum);
+        }
+    }
+    return product;
+}
+
+template <template <typename> class Semiring>
+void checkSemiring(const vector<vector<int>> &a, const vector<vector<int>> &b)
+{
+    Graph expected, dense1, dense2, sparse1, sparse2;
+    expected.loadGraph(naiveProduct<Semiring>(a, b));
+    dense1.loadGraph(a, Representation::Dense);
+    dense2.loadGraph(b, Representation::Dense);
+    sparse1.loadGraph(a, Representation::Sparse);
+    sparse2.loadGraph(b, Representation::Sparse);
+    CHECK(multiply<Semiring>(dense1, dense2) == expected);
+    CHECK(multiply<Semiring>(sparse1, sparse2) == expected);
+    CHECK(multiply<Semiring>(sparse1, sparse2).getEdges() == expected.getEdges());
+}
+
+TEST_CASE("Test semiring matrix products")
+{
+    size_t n = 45;
+    vector<vector<int>> a(n, vector<int>(n, 0)), b(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            a[i][j] = (i * 5 + j) % 4 == 0 ? int((i + j) % 9) - 3 : 0;
+            b[i][j] = (i + j * 3) % 5 == 0 ? int(i % 7) + 1 : 0;
+        }
+    }
+    checkSemiring<PlusTimes>(a, b);
+    checkSemiring<MinPlus>(a, b);
+    checkSemiring<OrAnd>(a, b);
+    checkSemiring<MaxMin>(a, b);
+
+    // Two hops of a path: the shortest route, whether there is one, and its narrowest edge
+    Graph path;
+    path.loadGraph({{0, 4, 9}, {0, 0, 2}, {0, 0, 0}});
+    Graph shortest = multiply<MinPlus>(path, path);
+    CHECK(shortest.getWeight(0, 2) == 6);
+    CHECK(shortest.getEdges() == 1);
+    CHECK(multiply<OrAnd>(path, path).getWeight(0, 2) == 1);
+    CHECK(multiply<MaxMin>(path, path).getWeight(0, 2) == 2);
+    CHECK(path * path == multiply<PlusTimes>(path, path));
+}
+
+TEST_CASE("Test matrix powers")
+{
+    vector<vector<int>> matrix = {{0, 1, 0, 2}, {1, 0, 3, 0}, {0, 0, 0, 1}, {1, 1, 0, 0}};
+    Graph g;
+    g.loadGraph(matrix);
+    CHECK(g.pow(1) == g);
+    CHECK(g.pow(5) == g * g * g * g * g);
+    Graph identity = g.pow(0);
+    CHECK(identity.getEdges() == 4);
+    CHECK(identity.getWeight(2, 2) == 1);
+
+    // Walk counts of a complete graph on 3 vertices grow as 2^k, past what int holds
+    Graph triangle;
+    triangle.loadGraph({{0, 1, 1}, {1, 0, 1}, {1, 1, 0}});
+    CHECK_THROWS(triangle.pow(40));
+    BasicGraph<int64_t> wide;
+    wide.loadGraph({{0, 1, 1}, {1, 0, 1}, {1, 1, 0}});
+    int64_t walks = ((int64_t(1) << 40) + 2) / 3; // closed walks of 40 edges
+    CHECK(wide.pow(40).getWeight(0, 0) == walks);
+    // Past 2^63 the 64-bit sums themselves would overflow
+    CHECK_THROWS_AS(wide.pow(70), overflow_error);
+    const int64_t large = int64_t(1) << 40;
+    for (Representation storage : {Representation::Dense, Representation::Sparse})
+    {
+        BasicGraph<int64_t> chain;
+        chain.loadGraph({{0, large, 0}, {0, 0, large}, {0, 0, 0}}, storage);
+        CHECK_THROWS_AS(chain * chain, overflow_error);
+        BasicGraph<int64_t> nilpotent;
+        nilpotent.loadGraph({{0, large, 0}, {0, 0, 0}, {0, 0, 0}}, storage);
+        CHECK((nilpotent * nilpotent).getEdges() == 0);
+        CHECK(nilpotent.pow(1).getWeight(0, 1) == large);
+    }
+    const int64_t prime = 1000000007;
+    CHECK(triangle.pow(40, prime).getWeight(0, 0) == walks % prime);
+    CHECK(triangle.pow(40, prime).getWeight(0, 1) == (walks - 1) % prime);
+    Graph power = g.pow(7);
+    Graph reduced = g.pow(7, 5);
+    bool same = true;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        for (size_t j = 0; j < 4; ++j)
+        {
+            same = same && reduced.getWeight(i, j) == power.getWeight(i, j) % 5;
+        }
+    }
+    CHECK(same);
+    CHECK_THROWS(g.pow(2, 0));
+
+    // Shortest distances using at most k edges
+    Graph path;
+    path.loadGraph({{0, 1, 0, 0, 9}, {0, 0, 1, 0, 0}, {0, 0, 0, 1, 0}, {0, 0, 0, 0, 1}, {0, 0, 0, 0, 0}});
+    CHECK(path.pow<MinPlus>(1).getWeight(0, 4) == 9);
+    CHECK(path.pow<MinPlus>(3).getWeight(0, 4) == 9);
+    CHECK(path.pow<MinPlus>(4).getWeight(0, 4) == 4);
+    CHECK(path.pow<MinPlus>(4).getWeight(1, 3) == 2);
+    CHECK(path.pow<OrAnd>(2).getWeight(0, 2) == 1);
+    CHECK(path.pow<OrAnd>(2).getWeight(0, 3) == 0);
+}
+
+TEST_CASE("Test bit-packed boolean products and transitive closure")
+{
+    // Two cycles joined by a bridge, a self loop, a chain and an isolated vertex; 130 vertices span three words per row
+    size_t n = 130;
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (size_t i = 0; i < 40; ++i)
+    {
+        matrix[i][(i + 1) % 40] = 1;
+        matrix[40 + i][40 + (i + 1) % 40] = 1;
+    }
+    matrix[39][70] = 1;
+    matrix[100][100] = 1;
+    for (size_t i = 101; i < 128; ++i)
+    {
+        matrix[i][i + 1] = 1;
+    }
+    matrix[128][0] = 1;
+    Graph g;
+    g.loadGraph(matrix);
+    BitMatrix closure = Algorithms::transitiveClosure(g);
+
+    // Compare with a breadth-first search from every vertex
+    bool same = true;
+    for (size_t s = 0; s < n; ++s)
+    {
+        vector<bool> reached(n, false);
+        vector<size_t> queue = {s};
+        for (size_t q = 0; q < queue.size(); ++q)
+        {
+            for (size_t t = 0; t < n; ++t)
+            {
+                if (matrix[queue[q]][t] != 0 && !reached[t])
+                {
+                    reached[t] = true;
+                    queue.push_back(t);
+                }
+            }
+        }
+        for (size_t t = 0; t < n; ++t)
+        {
+            same = same && closure.test(s, t) == reached[t];
+        }
+    }
+    CHECK(same);
+    CHECK(closure.test(0, 0));
+    CHECK(closure.test(0, 45));
+    CHECK_FALSE(closure.test(45, 0));
+    CHECK(closure.test(100, 100));
+    CHECK_FALSE(closure.test(101, 101));
+    CHECK(closure.test(101, 79));
+    CHECK_FALSE(closure.test(129, 129));
+
+    BitMatrix adjacency = *g.adjacencyBits();
+    BitMatrix square = adjacency * adjacency;
+    bool sameSquare = true;
+    Graph twoSteps = g * g;
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            sameSquare = sameSquare && square.test(i, j) == (twoSteps.getWeight(i, j) != 0);
+        }
+    }
+    CHECK(sameSquare);
+}
+
+TEST_CASE("Test all-pairs shortest paths")
+{
+    Graph small;
+    small.loadGraph({{0, 4, 1}, {0, 0, 0}, {0, 2, 0}});
+    PathMatrix<int> tiny = Algorithms::allPairsShortestPaths(small, true);
+    CHECK(tiny.distance(0, 1) == 3);
+    CHECK(tiny.distance(1, 0) == WeightTraits<int>::infinity());
+    CHECK(tiny.path(0, 1) == vector<size_t>{0, 2, 1});
+    CHECK(tiny.path(1, 0).empty());
+    CHECK_FALSE(tiny.hasNegativeCycle());
+    CHECK_THROWS(Algorithms::allPairsShortestPaths(small).nextHop(0, 1));
+
+    // An acyclic graph with negative edges over three blocks, compared with a plain Floyd-Warshall
+    size_t n = 150;
+    const int64_t infinity = WeightTraits<int>::infinity();
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = i + 1; j < n; ++j)
+        {
+            if ((i * 7 + j * 13) % 11 == 0)
+            {
+                matrix[i][j] = int((i * 3 + j) % 17) - 4;
+            }
+        }
+    }
+    matrix[10][11] = 1;
+    matrix[11][12] = 1;
+    vector<vector<int64_t>> expected(n, vector<int64_t>(n, infinity));
+    for (size_t i = 0; i < n; ++i)
+    {
+        expected[i][i] = 0;
+        for (size_t j = 0; j < n; ++j)
+        {
+            if (matrix[i][j] != 0)
+            {
+                expected[i][j] = matrix[i][j];
+            }
+        }
+    }
+    for (size_t k = 0; k < n; ++k)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (expected[i][k] != infinity && expected[k][j] != infinity)
+                {
+                    expected[i][j] = min(expected[i][j], expected[i][k] + expected[k][j]);
+                }
+            }
+        }
+    }
+
+    // Every recorded path must be as long as its distance
+    auto pathLength = [&](const PathMatrix<int> &paths, size_t from, size_t to)
+    {
+        vector<size_t> vertices = paths.path(from, to);
+        int64_t length = 0;
+        for (size_t v = 0; v + 1 < vertices.size(); ++v)
+        {
+            length += matrix[vertices[v]][vertices[v + 1]];
+        }
+        return length;
+    };
+    for (Representation storage : {Representation::Dense, Representation::Sparse})
+    {
+        Graph g;
+        g.loadGraph(matrix, storage);
+        PathMatrix<int> paths = Algorithms::allPairsShortestPaths(g, true);
+        bool same = true;
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                same = same && paths.distance(i, j) == expected[i][j];
+                if (expected[i][j] != infinity)
+                {
+                    same = same && pathLength(paths, i, j) == expected[i][j];
+                }
+            }
+        }
+        CHECK(same);
+        CHECK_FALSE(paths.hasNegativeCycle());
+    }
+
+    // Closing 10 -> 11 -> 12 -> 10 into a negative cycle makes every pair with a path through it unbounded
+    matrix[12][10] = -5;
+    Graph cyclic;
+    cyclic.loadGraph(matrix);
+    PathMatrix<int> paths = Algorithms::allPairsShortestPaths(cyclic, true);
+    CHECK(paths.hasNegativeCycle());
+    bool marked = true;
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            bool throughCycle = expected[i][12] != infinity && expected[10][j] != infinity;
+            if (throughCycle)
+            {
+                marked = marked && paths.distance(i, j) == WeightTraits<int>::negativeInfinity() && paths.path(i, j).empty();
+            }
+            else
+            {
+                marked = marked && paths.distance(i, j) == expected[i][j];
+            }
+        }
+    }
+    CHECK(marked);
+    CHECK(paths.distance(11, 11) == WeightTraits<int>::negativeInfinity());
+}
+
+TEST_CASE("Test path lengths of 64-bit weights that overflow")
+{
+    const int64_t large = int64_t(1) << 62;
+    BasicGraph<int64_t> g;
+    g.loadGraph({{0, large, 0, 0}, {0, 0, large, 0}, {0, 0, 0, 1}, {0, 0, 0, 0}});
+    CHECK_THROWS_AS(Algorithms::shortestPath(g, 0, 3), overflow_error);
+    CHECK_THROWS_AS(Algorithms::allPairsShortestPaths(g), overflow_error);
+    g.loadGraph({{0, large, 0, 0}, {0, 0, large, 0}, {0, 0, 0, -1}, {0, 0, 0, 0}});
+    CHECK_THROWS_AS(Algorithms::shortestPath(g, 0, 3), overflow_error);
+    g.loadGraph({{0, large, 0, 0}, {0, 0, large / 2, 0}, {0, 0, 0, 1}, {0, 0, 0, 0}});
+    CHECK(Algorithms::shortestPath(g, 0, 3) == vector<size_t>{0, 1, 2, 3});
+    CHECK(Algorithms::allPairsShortestPaths(g).distance(0, 3) == large + large / 2 + 1);
+}
+
+TEST_CASE("Test Johnson all-pairs shortest paths")
+{
+    // A sparse graph with negative edges but no negative cycle: a forward path loses at most 3 per vertex it passes,
+    // and every backward edge weighs more than 600
+    size_t n = 200;
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t j = (i * 37 + 11) % n;
+        matrix[i][j] = int(i % 13) + (j < i ? 601 : 1);
+        if (i + 3 < n)
+        {
+            matrix[i][i + 3] = int(i % 5) - 3;
+        }
+        if (i + 1 < n)
+        {
+            matrix[i][i + 1] = int(i % 7) - 2;
+        }
+    }
+    Graph g;
+    g.loadGraph(matrix, Representation::Sparse);
+    PathMatrix<int> expected = Algorithms::allPairsShortestPaths(g);
+    REQUIRE_FALSE(expected.hasNegativeCycle());
+
+    vector<vector<int64_t>> distances(n);
+    vector<char> parentsMatch(n, false); // one byte per source, since sources are visited concurrently
+    bool computed = Algorithms::johnsonShortestPaths(g, [&](size_t source, const int64_t *distance, const size_t *parent)
+                                                     {
+                                                         distances[source].assign(distance, distance + n);
+                                                         bool match = parent[source] == PathMatrix<int>::NO_VERTEX;
+                                                         for (size_t v = 0; v < n; ++v)
+                                                         {
+                                                             if (v != source && distance[v] != WeightTraits<int>::infinity())
+                                                             {
+                                                                 match = match && distance[v] == distance[parent[v]] + matrix[parent[v]][v];
+                                                             }
+                                                         }
+                                                         parentsMatch[source] = match; });
+    CHECK(computed);
+    bool same = true;
+    for (size_t i = 0; i < n; ++i)
+    {
+        same = same && parentsMatch[i];
+        for (size_t j = 0; j < n; ++j)
+        {
+            same = same && distances[i][j] == expected.distance(i, j);
+        }
+    }
+    CHECK(same);
+
+    Graph cycle;
+    cycle.loadGraph({{0, 1, 0}, {0, 0, -3}, {1, 0, 0}});
+    size_t visited = 0;
+    CHECK_FALSE(Algorithms::johnsonShortestPaths(cycle, [&](size_t, const int64_t *, const size_t *)
+                                                 { ++visited; }));
+    CHECK(visited == 0);
+}
+
+TEST_CASE("Test finding a negative cycle")
+{
+    // The cycle 5 -> 6 -> 7 -> 5 weighs -1 and is not reachable from vertex 0
+    vector<vector<int>> matrix = {{0, 2, 0, 0, 0, 0, 0, 0},
+                                  {0, 0, -1, 0, 0, 0, 0, 0},
+                                  {3, 0, 0, 0, 0, 0, 0, 0},
+                                  {0, 0, 0, 0, 4, 0, 0, 0},
+                                  {0, 0, 0, 0, 0, 1, 0, 0},
+                                  {0, 0, 0, 0, 0, 0, 2, 0},
+                                  {0, 0, 0, 0, 0, 0, 0, -4},
+                                  {0, 0, 0, 0, 0, 1, 0, 0}};
+    for (Representation storage : {Representation::Dense, Representation::Sparse})
+    {
+        Graph g;
+        g.loadGraph(matrix, storage);
+        vector<size_t> cycle = Algorithms::findNegativeCycle(g);
+        REQUIRE(cycle.size() == 3);
+        int weight = 0;
+        for (size_t i = 0; i < cycle.size(); ++i)
+        {
+            int edge = g.getWeight(cycle[i], cycle[(i + 1) % cycle.size()]);
+            CHECK(edge != 0);
+            weight += edge;
+        }
+        CHECK(weight == -1);
+        CHECK(Algorithms::negativeCycle(g));
+    }
+
+    matrix[6][7] = -2;
+    Graph positive;
+    positive.loadGraph(matrix);
+    CHECK(Algorithms::findNegativeCycle(positive).empty());
+    CHECK(Algorithms::findNegativeCycle(Graph()).empty());
+}
+
+TEST_CASE("Test Dijkstra shortest paths on non-negative weights")
+{
+    Graph g;
+    g.loadGraph({{0, 2, 0}, {1, 0, 7}, {0, 3, 0}});
+    CHECK(g.weightRange().smallest == 1);
+    CHECK(g.weightRange().largest == 7);
+    CHECK(g.weightRange().nonNegative());
+    g *= -1; // must drop the cached range
+    CHECK(g.weightRange().smallest == -7);
+    CHECK_FALSE(g.view().weightRange().nonNegative());
+    CHECK(Graph().weightRange().nonNegative());
+
+    // Every path must be as long as the Floyd-Warshall distance, with the graph's cached range or a bare view's
+    size_t n = 300;
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t k = 1; k <= 4; ++k)
+        {
+            matrix[i][(i * k * 17 + k * 29) % n] = int((i + k) % 9) + 1;
+        }
+    }
+    for (Representation storage : {Representation::Dense, Representation::Sparse})
+    {
+        Graph weighted;
+        weighted.loadGraph(matrix, storage);
+        PathMatrix<int> expected = Algorithms::allPairsShortestPaths(weighted);
+        GraphView<int> bare = storage == Representation::Dense ? GraphView<int>(weighted.row(0).data(), n) : weighted.view();
+        bool same = true;
+        for (size_t s = 0; s < n; s += 7)
+        {
+            for (size_t t = 0; t < n; t += 5)
+            {
+                vector<size_t> path = Algorithms::shortestPath(s % 2 == 0 ? weighted.view() : bare, s, t);
+                int64_t length = 0;
+                for (size_t v = 0; v + 1 < path.size(); ++v)
+                {
+                    length += matrix[path[v]][path[v + 1]];
+                }
+                same = same && (path.empty() ? expected.distance(s, t) == WeightTraits<int>::infinity()
+                                             : path.front() == s && path.back() == t && length == expected.distance(s, t));
+            }
+        }
+        CHECK(same);
+    }
+}
+
+TEST_CASE("Test shortest path strategies")
+{
+    // The same topology with uniform, small integral, large and negative weights
+    size_t n = 120;
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t k = 1; k <= 3; ++k)
+        {
+            matrix[i][(i * k * 7 + k * 13) % n] = int((i * k) % 11) + 1;
+        }
+    }
+    auto reweighted = [&](int (*weight)(int))
+    {
+        vector<vector<int>> copy = matrix;
+        for (auto &row : copy)
+        {
+            for (int &w : row)
+            {
+                w = w != 0 ? weight(w) : 0;
+            }
+        }
+        return copy;
+    };
+    struct Case
+    {
+        vector<vector<int>> weights;
+        PathStrategy strategy;
+    };
+    vector<Case> cases = {{reweighted([](int)
+                                      { return 3; }),
+                           PathStrategy::BreadthFirst},
+                          {matrix, PathStrategy::Buckets},
+                          {reweighted([](int w)
+                                      { return w * 1000; }),
+                           PathStrategy::Bidirectional},
+                          {reweighted([](int w)
+                                      { return w == 5 ? -1 : w + 1; }),
+                           PathStrategy::BellmanFord}};
+    for (const Case &c : cases)
+    {
+        Graph g;
+        g.loadGraph(c.weights, Representation::Sparse);
+        PathMatrix<int> expected = Algorithms::allPairsShortestPaths(g);
+        bool same = true;
+        bool strategy = true;
+        for (size_t s = 0; s < n; s += 11)
+        {
+            for (size_t t = 0; t < n; t += 3)
+            {
+                QueryStats stats;
+                vector<size_t> path = Algorithms::shortestPath(g, s, t, stats);
+                strategy = strategy && stats.strategy == c.strategy && stats.settled >= 1;
+                int64_t length = 0;
+                for (size_t v = 0; v + 1 < path.size(); ++v)
+                {
+                    length += c.weights[path[v]][path[v + 1]];
+                }
+                int64_t distance = expected.distance(s, t);
+                same = same && (path.empty() ? distance == WeightTraits<int>::infinity() || distance == WeightTraits<int>::negativeInfinity()
+                                             : length == distance);
+            }
+        }
+        CHECK(same);
+        CHECK(strategy);
+    }
+
+    // Breadth-first search stops once the end is reached
+    Graph line;
+    line.loadGraph({{0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}, {0, 0, 0, 0}});
+    QueryStats stats;
+    CHECK(Algorithms::shortestPath(line, 0, 1, stats) == vector<size_t>{0, 1});
+    CHECK(stats.strategy == PathStrategy::BreadthFirst);
+    CHECK(stats.settled == 2);
+}
+
+TEST_CASE("Test queue-based Bellman-Ford")
+{
+    // Negative edges without a negative cycle: distances must match Floyd-Warshall
+    size_t n = 250;
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t k = 1; k <= 3; ++k)
+        {
+            size_t j = (i * k * 31 + k * 7) % n;
+            matrix[i][j] = j > i ? int((i + k) % 10) - 4 : int((i + k) % 10) + 1000;
+        }
+    }
+    Graph g;
+    g.loadGraph(matrix, Representation::Sparse);
+    PathMatrix<int> expected = Algorithms::allPairsShortestPaths(g);
+    REQUIRE_FALSE(expected.hasNegativeCycle());
+    bool same = true;
+    for (size_t s = 0; s < n; s += 13)
+    {
+        for (size_t t = 0; t < n; ++t)
+        {
+            QueryStats stats;
+            vector<size_t> path = Algorithms::shortestPath(g, s, t, stats);
+            int64_t length = 0;
+            for (size_t v = 0; v + 1 < path.size(); ++v)
+            {
+                length += matrix[path[v]][path[v + 1]];
+            }
+            same = same && stats.strategy == PathStrategy::BellmanFord &&
+                   (path.empty() ? expected.distance(s, t) == WeightTraits<int>::infinity() : length == expected.distance(s, t));
+        }
+    }
+    CHECK(same);
+
+    // 1 -> 2 -> 3 -> 1 weighs -1: everything after it is unbounded, and 0 -> 4 -> 5 is not affected
+    Graph cyclic;
+    cyclic.loadGraph({{0, 1, 0, 0, 2, 0, 0},
+                      {0, 0, 1, 0, 0, 0, 0},
+                      {0, 0, 0, 1, 0, 0, 0},
+                      {0, -3, 0, 0, 0, 0, 1},
+                      {0, 0, 0, 0, 0, 3, 0},
+                      {0, 0, 0, 0, 0, 0, 0},
+                      {0, 0, 0, 0, 0, 0, 0}});
+    CHECK(Algorithms::shortestPath(cyclic, 0, 5) == vector<size_t>{0, 4, 5});
+    CHECK(Algorithms::shortestPath(cyclic, 0, 6).empty());
+    CHECK(Algorithms::shortestPath(cyclic, 0, 2).empty());
+    CHECK(Algorithms::shortestPath(cyclic, 4, 5) == vector<size_t>{4, 5});
+}
+
+TEST_CASE("Test bidirectional Dijkstra")
+{
+    // The transpose is cached until the graph changes
+    Graph g;
+    g.loadGraph({{0, 2, 0}, {0, 0, 7}, {4, 0, 0}});
+    shared_ptr<const Graph> reversed = g.transposed();
+    CHECK(g.transposed() == reversed);
+    CHECK(reversed->getWeight(1, 0) == 2);
+    CHECK(reversed->getWeight(0, 2) == 4);
+    CHECK(reversed->getWeight(0, 1) == 0);
+    CHECK(reversed->getInDegree(0) == 1);
+    g += 1;
+    CHECK(g.transposed() != reversed);
+    CHECK(g.transposed()->getWeight(2, 1) == 8);
+
+    // Both searches must agree with Floyd-Warshall, including pairs in different components
+    size_t n = 240;
+    vector<vector<double>> matrix(n, vector<double>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t k = 1; k <= 3; ++k)
+        {
+            size_t j = (i * k * 19 + k * 11) % (n / 2) + (i < n / 2 ? 0 : n / 2);
+            matrix[i][j] = double((i * k) % 13) * 0.75 + 0.5;
+        }
+    }
+    vector<double> cells; // a bare view has no owning graph to transpose
+    for (const vector<double> &row : matrix)
+    {
+        cells.insert(cells.end(), row.begin(), row.end());
+    }
+    GraphView<double> bare(cells.data(), n);
+    for (Representation storage : {Representation::Dense, Representation::Sparse})
+    {
+        BasicGraph<double> weighted;
+        weighted.loadGraph(matrix, storage);
+        PathMatrix<double> expected = Algorithms::allPairsShortestPaths(weighted);
+        bool same = true;
+        bool strategy = true;
+        for (size_t s = 0; s < n; s += 9)
+        {
+            for (size_t t = 0; t < n; t += 4)
+            {
+                QueryStats stats;
+                bool owned = (s + t) % 2 == 0;
+                vector<size_t> path = Algorithms::shortestPath(owned ? weighted.view() : bare, s, t, stats);
+                strategy = strategy && (s == t || stats.strategy == (owned ? PathStrategy::Bidirectional : PathStrategy::Dijkstra));
+                double length = 0;
+                for (size_t v = 0; v + 1 < path.size(); ++v)
+                {
+                    length += matrix[path[v]][path[v + 1]];
+                }
+                same = same && (path.empty() ? expected.distance(s, t) == WeightTraits<double>::infinity()
+                                             : path.front() == s && path.back() == t && abs(length - expected.distance(s, t)) < 1e-9);
+            }
+        }
+        CHECK(same);
+        CHECK(strategy);
+    }
+}
+
+TEST_CASE("Test parallelFor runs every index once on every call")
+{
+    vector<int> hits(1000, 0);
+    atomic<size_t> nested(0);
+    for (int round = 0; round < 50; ++round)
+    {
+        parallelFor(0, hits.size(), [&](size_t begin, size_t end)
+                    {
+                        for (size_t k = begin; k < end; ++k)
+                        {
+                            ++hits[k];
+                        }
+                        // A nested call runs on the thread of its slice
+                        parallelFor(begin, end, [&](size_t innerBegin, size_t innerEnd)
+                                    { nested += innerEnd - innerBegin; });
+                    });
+    }
+    CHECK(count(hits.begin(), hits.end(), 50) == 1000);
+    CHECK(nested == 50 * 1000);
+
+    CHECK_THROWS_AS(parallelFor(0, 100, [](size_t begin, size_t)
+                                {
+                                    if (begin == 0)
+                                    {
+                                        throw runtime_error("first slice");
+                                    }
+                                }),
+                    runtime_error);
+    size_t total = 0;
+    parallelFor(0, 1, [&](size_t begin, size_t end)
+                { total += end - begin; });
+    CHECK(total == 1);
+
+    // Callers on different threads share the pool or run alone, and never wait for each other
+    vector<int> left(5000, 0);
+    vector<int> right(5000, 0);
+    auto increment = [](vector<int> &values)
+    {
+        for (int round = 0; round < 20; ++round)
+        {
+            parallelFor(0, values.size(), [&](size_t begin, size_t end)
+                        {
+                            for (size_t k = begin; k < end; ++k)
+                            {
+                                ++values[k];
+                            } });
+        }
+    };
+    thread other(increment, ref(right));
+    increment(left);
+    other.join();
+    CHECK(count(left.begin(), left.end(), 20) == 5000);
+    CHECK(count(right.begin(), right.end(), 20) == 5000);
+}
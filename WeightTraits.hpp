@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ariel
+{
+    /// @brief Describes how sums of edge weights of type W are accumulated.
+    /// Path distances and matrix products are computed in Accumulator: 64-bit integers for integral
+    /// weights and double for floating-point weights. That is wider than every weight type but
+    /// int64_t, whose sums can leave it, so distances are added with add() and subtract(), which
+    /// throw overflow_error for it instead of wrapping around. Specialize it to store other weight types.
+    template <typename W>
+    struct WeightTraits
+    {
+        static_assert(std::is_arithmetic<W>::value && std::is_signed<W>::value, "Edge weights must be signed numbers");
+
+        using Accumulator = typename std::conditional<std::is_floating_point<W>::value, double, std::int64_t>::type;
+
+        // Distance of a vertex that has not been reached
+        static constexpr Accumulator infinity() { return std::numeric_limits<Accumulator>::max(); }
+        // Distance of a vertex that can be reached through a negative cycle
+        static constexpr Accumulator negativeInfinity() { return std::numeric_limits<Accumulator>::lowest(); }
+
+        // a + b, checked when Accumulator is no wider than W
+        static Accumulator add(Accumulator a, Accumulator b)
+        {
+            if constexpr (narrow)
+            {
+                Accumulator sum;
+                if (__builtin_add_overflow(a, b, &sum))
+                {
+                    throw std::overflow_error("A path length overflows 64-bit integers");
+                }
+                return sum;
+            }
+            else
+            {
+                return a + b;
+            }
+        }
+
+        // a - b, checked when Accumulator is no wider than W
+        static Accumulator subtract(Accumulator a, Accumulator b)
+        {
+            if constexpr (narrow)
+            {
+                Accumulator difference;
+                if (__builtin_sub_overflow(a, b, &difference))
+                {
+                    throw std::overflow_error("A path length overflows 64-bit integers");
+                }
+                return difference;
+            }
+            else
+            {
+                return a - b;
+            }
+        }
+
+    private:
+        static constexpr bool narrow = std::is_integral<W>::value && sizeof(W) >= sizeof(Accumulator);
+    };
+} // namespace ariel